@@ -0,0 +1,61 @@
+/*
+    Bash Terminal
+        cmake -S . -B build -DTCI_BUILD_BENCH=ON -DCMAKE_BUILD_TYPE=Release
+        cmake --build build --target tci_bench
+        ./build/tci_bench --benchmark_filter=BringUp
+*/
+
+#include <benchmark/benchmark.h>
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "TraceSystem.h"
+#include "TraceControllerInterface.h"
+#include "ProbeHwAccess.h"
+#include "LatencyHwAccess.h"
+#include "ControllerScheduler.h"
+
+using namespace tci;
+
+namespace {
+    // One simulated SoC behind its own latency-injecting probe
+    struct Soc {
+        explicit Soc(std::chrono::microseconds roundTrip)
+            : sys(4096), probe(sys.mmioBus, {}, ProbeHwAccess::LogMode::Off), hw(probe, roundTrip),
+              tci(hw, TraceSystem::TR_TE_BASE, TraceSystem::TR_FUNNEL_BASE, TraceSystem::TR_RAM_SINK_BASE) {}
+
+        TraceSystem sys;
+        ProbeHwAccess probe;
+        LatencyHwAccess hw;
+        TraceControllerInterface tci;
+    };
+}
+
+// configure + start on every system. Args: systems, round-trip (us), mode (0 = blocking calls one system
+// after another, 1 = ControllerScheduler on one thread). Reports systems brought up per second.
+static void BM_BringUp(benchmark::State& state) {
+    const auto systems = static_cast<std::size_t>(state.range(0));
+    const std::chrono::microseconds roundTrip(state.range(1));
+    const bool async = state.range(2) != 0;
+    std::vector<std::unique_ptr<Soc>> socs;
+    for (std::size_t i = 0; i < systems; ++i) socs.push_back(std::make_unique<Soc>(roundTrip));
+
+    ControllerScheduler scheduler;
+    for (auto _ : state) {
+        if (async) {
+            scheduler.clear();
+            for (auto& soc : socs) scheduler.add(soc->tci, {ControllerScheduler::Operation::Configure, ControllerScheduler::Operation::Start});
+            scheduler.run();
+        } else {
+            for (auto& soc : socs) {
+                soc->tci.configure();
+                soc->tci.start();
+            }
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(systems)); // systems/s
+}
+BENCHMARK(BM_BringUp)->ArgsProduct({{1, 8, 64}, {10, 100}, {0, 1}})->UseRealTime();
@@ -0,0 +1,46 @@
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+#include "TraceSystem.h"
+#include "TraceControllerInterface.h"
+#include "TraceControlRegisters.h"
+#include "BusHwAccess.h"
+
+using namespace tci;
+
+// Sustained instruction rate with the drainer thread running concurrently.
+// Arg: sink size in KB. Counters report dropped bytes (0 means the drainer kept up).
+static void BM_ContinuousCapture(benchmark::State& state) {
+    const auto sinkBytes = static_cast<std::uint32_t>(state.range(0)) * 1024u;
+    constexpr std::size_t batch = 256;
+    std::vector<std::uint32_t> pcs(batch), opcodes(batch);
+    for (std::size_t i = 0; i < batch; ++i) {
+        pcs[i] = 0x80000000u + static_cast<std::uint32_t>(4 * i);
+        opcodes[i] = 0x00000013u;
+    }
+
+    TraceSystem sys{sinkBytes};
+    BusHwAccess hw{sys.mmioBus};
+    TraceControllerInterface tci{hw, TraceSystem::TR_TE_BASE, TraceSystem::TR_FUNNEL_BASE, TraceSystem::TR_RAM_SINK_BASE};
+    tci.configure();
+    tci.start();
+    std::uint64_t checksum = 0;
+    tci.startContinuousCapture([&](const std::uint32_t* words, std::size_t n) {
+        checksum += words[n - 1];
+    });
+
+    for (auto _ : state) {
+        sys.emitTraceBatch(pcs.data(), opcodes.data(), batch);
+    }
+    tci.stop();
+    tci.stopContinuousCapture();
+    benchmark::DoNotOptimize(checksum);
+
+    const auto emitted = static_cast<double>(state.iterations()) * batch;
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(batch));
+    state.counters["captured_insts"] = static_cast<double>(tci.capturedWords() / 2);
+    state.counters["dropped_bytes"] = emitted * 8 - static_cast<double>(tci.capturedWords() * 4);
+}
+BENCHMARK(BM_ContinuousCapture)->Arg(64)->Arg(1024)->UseRealTime();
@@ -0,0 +1,54 @@
+/*
+    Bash Terminal
+        cmake -S . -B build -DTCI_BUILD_BENCH=ON -DCMAKE_BUILD_TYPE=Release
+        cmake --build build --target tci_bench
+        ./build/tci_bench --benchmark_filter=Deferred
+*/
+
+#include <benchmark/benchmark.h>
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+#include "TraceSystem.h"
+#include "TraceControllerInterface.h"
+#include "ProbeHwAccess.h"
+#include "LatencyHwAccess.h"
+
+using namespace tci;
+
+namespace {
+    // Controller over a latency-injecting probe. queueing = false models a strictly synchronous probe.
+    struct LatencyRig {
+        LatencyRig(std::size_t encoders, std::chrono::microseconds roundTrip, bool queueing)
+            : sys(4096, TraceRamSink::FullPolicy::DropWhenFull, encoders),
+              probe(sys.mmioBus, {}, ProbeHwAccess::LogMode::Off),
+              hw(probe, roundTrip, queueing),
+              tci(hw, sys.encoderBases(), TraceSystem::TR_FUNNEL_BASE, TraceSystem::TR_RAM_SINK_BASE) {}
+
+        TraceSystem sys;
+        ProbeHwAccess probe;
+        LatencyHwAccess hw;
+        TraceControllerInterface tci;
+    };
+}
+
+// configure + start + stop. Args: encoders, round-trip (us), queueing (0 = synchronous, 1 = deferred).
+// Shadow cache dropped per iteration so start/stop pay their read-modify-write reads.
+// Reports round-trips per sequence set; wall time follows round-trips x latency.
+static void BM_DeferredSequence(benchmark::State& state) {
+    LatencyRig rig{static_cast<std::size_t>(state.range(0)), std::chrono::microseconds(state.range(1)), state.range(2) != 0};
+
+    const std::uint64_t before = rig.hw.roundTrips();
+    for (auto _ : state) {
+        rig.tci.invalidateShadow();
+        rig.tci.configure();
+        rig.tci.invalidateShadow();
+        rig.tci.start();
+        rig.tci.stop();
+    }
+    state.SetItemsProcessed(state.iterations()); // sequence sets/s
+    state.counters["round_trips"] = benchmark::Counter(static_cast<double>(rig.hw.roundTrips() - before) / state.iterations());
+}
+BENCHMARK(BM_DeferredSequence)->ArgsProduct({{1, 4}, {0, 10, 100}, {0, 1}})->UseRealTime();
@@ -0,0 +1,81 @@
+/*
+    Bash Terminal
+        cmake -S . -B build -DTCI_BUILD_BENCH=ON -DCMAKE_BUILD_TYPE=Release
+        cmake --build build --target tci_bench
+        ./build/tci_bench --benchmark_filter=FunnelTree
+*/
+
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+#include "TraceSystem.h"
+#include "TraceControllerInterface.h"
+#include "TraceControlRegisters.h"
+#include "BusHwAccess.h"
+
+using namespace tci;
+
+namespace {
+    // Uniform tree of `depth` funnel levels with `fanIn` inputs each (fanIn^depth encoders), started.
+    // queued: every funnel has input queues and the caller pumps them leaves first.
+    struct TreeRig {
+        TreeRig(std::size_t depth, std::size_t fanIn, bool queued)
+            : sys(1u << 20, TraceRamSink::FullPolicy::Circular, TraceSystem::Topology{std::vector<std::size_t>(depth, fanIn)}),
+              hw(sys.mmioBus), tci(hw, sys.encoderBases(), sys.funnelBases(), TraceSystem::TR_RAM_SINK_BASE) {
+            if (queued) {
+                for (std::size_t k = 0; k < sys.funnelCount(); ++k) sys.funnel(k).enableInputQueues();
+            }
+            tci.setVerifyPolicy(TraceControllerInterface::VerifyPolicy::Never);
+            tci.configure();
+            tci.start();
+        }
+        void pumpAll() {
+            for (std::size_t k = sys.funnelCount(); k-- > 0;) sys.funnel(k).pump();
+        }
+        TraceSystem sys;
+        BusHwAccess hw;
+        TraceControllerInterface tci;
+    };
+}
+
+// Aggregate emission rate: each iteration one hart (round-robin over all) retires a 256-instruction batch
+// that travels through every funnel level. Args: depth, fan-in.
+static void BM_FunnelTreeThroughput(benchmark::State& state) {
+    const auto depth = static_cast<std::size_t>(state.range(0));
+    const auto fanIn = static_cast<std::size_t>(state.range(1));
+    TreeRig rig{depth, fanIn, false};
+    constexpr std::size_t batch = 256;
+    std::vector<std::uint32_t> pcs(batch), opcodes(batch, 0x00000013u);
+    for (std::size_t i = 0; i < batch; ++i) pcs[i] = 0x80000000u + static_cast<std::uint32_t>(4 * i);
+
+    std::size_t hart = 0;
+    for (auto _ : state) {
+        rig.sys.emitTraceBatch(hart, pcs.data(), opcodes.data(), batch);
+        if (++hart == rig.sys.encoderCount()) hart = 0;
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(batch));
+    state.counters["encoders"] = static_cast<double>(rig.sys.encoderCount());
+}
+BENCHMARK(BM_FunnelTreeThroughput)->ArgsProduct({{1, 2, 3}, {2, 4, 16}});
+
+// End-to-end latency of one instruction from emitTrace until its bytes are in the sink: the iteration time.
+// Args: depth, fan-in, mode (0 = direct pushes, 1 = input queues pumped leaves first).
+static void BM_FunnelTreeLatency(benchmark::State& state) {
+    const auto depth = static_cast<std::size_t>(state.range(0));
+    const auto fanIn = static_cast<std::size_t>(state.range(1));
+    const bool queued = state.range(2) != 0;
+    TreeRig rig{depth, fanIn, queued};
+
+    std::size_t hart = 0;
+    std::uint32_t pc = 0x80000000u;
+    for (auto _ : state) {
+        rig.sys.emitTrace(hart, pc, 0x00000013u);
+        if (queued) rig.pumpAll();
+        if (++hart == rig.sys.encoderCount()) hart = 0;
+        pc += 4;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_FunnelTreeLatency)->ArgsProduct({{1, 2, 3}, {2, 4, 16}, {0, 1}});
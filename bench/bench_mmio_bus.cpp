@@ -0,0 +1,61 @@
+/*
+    Bash Terminal
+        cmake -S . -B build -DTCI_BUILD_BENCH=ON
+        cmake --build build --target tci_bench
+        ./build/tci_bench --benchmark_filter=MmioBus
+*/
+
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "MmioBus.h"
+
+using namespace tci;
+
+namespace {
+    // Minimal device: returns the offset so the decode result is observable
+    class EchoDevice : public IMmioDevice {
+    public:
+        std::uint32_t read32(std::uint32_t offset) override { return offset; }
+        void write32(std::uint32_t, std::uint32_t) override {}
+    };
+
+    // Maps `count` 4 KB components back to back starting at 0x1000 and reads
+    // from a shuffled set of addresses spread across all of them
+    void runDecode(benchmark::State& state, MmioBus::DecodeMode mode) {
+        const auto count = static_cast<std::uint32_t>(state.range(0));
+        constexpr std::uint32_t componentSize = 0x1000;
+
+        std::vector<EchoDevice> devices(count);
+        MmioBus bus;
+        bus.setDecodeMode(mode);
+        for (std::uint32_t i = 0; i < count; ++i) {
+            bus.addMapping(0x1000 + i * componentSize, componentSize, &devices[i]);
+        }
+
+        std::mt19937 rng(42);
+        std::vector<std::uint32_t> addresses(4096);
+        for (auto& a : addresses) {
+            a = 0x1000 + (rng() % count) * componentSize + (rng() % componentSize & ~0x3u);
+        }
+
+        std::size_t i = 0;
+        for (auto _ : state) {
+            benchmark::DoNotOptimize(bus.read32(addresses[i]));
+            i = (i + 1) & (addresses.size() - 1);
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+}
+
+static void BM_MmioBusDecodeLinear(benchmark::State& state) {
+    runDecode(state, MmioBus::DecodeMode::Linear);
+}
+BENCHMARK(BM_MmioBusDecodeLinear)->RangeMultiplier(4)->Range(1, 1024);
+
+static void BM_MmioBusDecodeIndexed(benchmark::State& state) {
+    runDecode(state, MmioBus::DecodeMode::Indexed);
+}
+BENCHMARK(BM_MmioBusDecodeIndexed)->RangeMultiplier(4)->Range(1, 1024);
@@ -0,0 +1,91 @@
+/*
+    Bash Terminal
+        cmake -S . -B build -DTCI_BUILD_BENCH=ON -DCMAKE_BUILD_TYPE=Release
+        cmake --build build --target tci_bench
+        ./build/tci_bench --benchmark_filter=MultiEncoder
+*/
+
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <memory>
+
+#include "TraceSystem.h"
+#include "TraceControllerInterface.h"
+#include "TraceControlRegisters.h"
+#include "BusHwAccess.h"
+
+using namespace tci;
+
+// N harts retire `batch` instructions each per iteration, round-robin, into one circular sink.
+// Args: encoder count, batch size (1 = emitTrace per instruction, otherwise emitTraceBatch).
+// items/s is the aggregate instruction rate over all harts.
+static void BM_MultiEncoderEmit(benchmark::State& state) {
+    const auto harts = static_cast<std::size_t>(state.range(0));
+    const auto batch = static_cast<std::size_t>(state.range(1));
+    TraceSystem sys{1u << 20, TraceRamSink::FullPolicy::Circular, harts};
+    BusHwAccess hw{sys.mmioBus};
+    TraceControllerInterface tci{hw, sys.encoderBases(), TraceSystem::TR_FUNNEL_BASE, TraceSystem::TR_RAM_SINK_BASE};
+    tci.setVerifyPolicy(TraceControllerInterface::VerifyPolicy::Never);
+    tci.configure();
+    tci.start();
+
+    std::vector<std::vector<std::uint32_t>> pcs(harts, std::vector<std::uint32_t>(batch));
+    std::vector<std::uint32_t> opcodes(batch, 0x00000013u);
+    for (std::size_t h = 0; h < harts; ++h) {
+        for (std::size_t i = 0; i < batch; ++i) {
+            pcs[h][i] = 0x80000000u + static_cast<std::uint32_t>(h * 0x100000 + 4 * i);
+        }
+    }
+
+    for (auto _ : state) {
+        for (std::size_t h = 0; h < harts; ++h) {
+            if (batch == 1) {
+                sys.emitTrace(h, pcs[h][0], opcodes[0]);
+            } else {
+                sys.emitTraceBatch(h, pcs[h].data(), opcodes.data(), batch);
+            }
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(harts * batch));
+}
+BENCHMARK(BM_MultiEncoderEmit)->ArgsProduct({{1, 2, 4, 8, 16}, {1, 256}});
+
+namespace {
+    // One system shared by all benchmark threads; thread i drives hart i
+    struct SharedRig {
+        explicit SharedRig(std::size_t harts)
+            : sys(1u << 20, TraceRamSink::FullPolicy::Circular, harts), hw(sys.mmioBus),
+              tci(hw, sys.encoderBases(), TraceSystem::TR_FUNNEL_BASE, TraceSystem::TR_RAM_SINK_BASE) {
+            sys.funnel().enableInputQueues(1u << 16, TraceFunnel::Backpressure::Stall);
+            tci.setVerifyPolicy(TraceControllerInterface::VerifyPolicy::Never);
+            tci.configure();
+            tci.start();
+            sys.funnel().startMergeThread();
+        }
+        ~SharedRig() { sys.funnel().stopMergeThread(); }
+        TraceSystem sys;
+        BusHwAccess hw;
+        TraceControllerInterface tci;
+    };
+    std::unique_ptr<SharedRig> gSharedRig;
+}
+
+// Concurrent harts: one producer thread per encoder, per-input queues and the funnel merge thread.
+// Arg: batch size. With UseRealTime, items/s is the aggregate rate over all threads.
+static void BM_MultiEncoderThreads(benchmark::State& state) {
+    const auto batch = static_cast<std::size_t>(state.range(0));
+    if (state.thread_index() == 0) gSharedRig = std::make_unique<SharedRig>(static_cast<std::size_t>(state.threads()));
+
+    const auto hart = static_cast<std::size_t>(state.thread_index());
+    std::vector<std::uint32_t> pcs(batch), opcodes(batch, 0x00000013u);
+    for (std::size_t i = 0; i < batch; ++i) pcs[i] = 0x80000000u + static_cast<std::uint32_t>(hart * 0x100000 + 4 * i);
+
+    for (auto _ : state) { // the loop start waits for every thread, so the rig exists here
+        gSharedRig->sys.emitTraceBatch(hart, pcs.data(), opcodes.data(), batch);
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(batch));
+    if (state.thread_index() == 0) gSharedRig.reset(); // the loop end waits for every thread as well
+}
+BENCHMARK(BM_MultiEncoderThreads)->Arg(256)->ThreadRange(1, 8)->UseRealTime();
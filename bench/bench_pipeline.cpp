@@ -0,0 +1,120 @@
+/*
+    Bash Terminal
+        cmake -S . -B build -DTCI_BUILD_BENCH=ON -DCMAKE_BUILD_TYPE=Release
+        cmake --build build --target tci_bench
+        ./build/tci_bench --benchmark_filter=Pipeline --benchmark_format=json > pipeline.json
+*/
+
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+#include "TraceSystem.h"
+#include "TraceControllerInterface.h"
+#include "ProbeHwAccess.h"
+#include "TraceControlRegisters.h"
+
+using namespace tci;
+
+namespace {
+    const std::vector<ProbeHwAccess::ComponentRegion> kRegions = {
+        {TraceSystem::TR_TE_BASE,       0x1000, "TraceEncoder"},
+        {TraceSystem::TR_FUNNEL_BASE,   0x1000, "TraceFunnel"},
+        {TraceSystem::TR_RAM_SINK_BASE, 0x1000, "TraceRamSink"}
+    };
+
+    // Full system + probe (no logging) + controller, configured and started
+    struct Rig {
+        explicit Rig(std::uint32_t sinkBytes, TraceRamSink::FullPolicy policy = TraceRamSink::FullPolicy::DropWhenFull)
+            : sys(sinkBytes, policy), probe(sys.mmioBus, kRegions, ProbeHwAccess::LogMode::Off),
+              tci(probe, TraceSystem::TR_TE_BASE, TraceSystem::TR_FUNNEL_BASE, TraceSystem::TR_RAM_SINK_BASE) {
+            tci.setVerifyPolicy(TraceControllerInterface::VerifyPolicy::Never);
+            tci.configure();
+            tci.start();
+        }
+        TraceSystem sys;
+        ProbeHwAccess probe;
+        TraceControllerInterface tci;
+    };
+
+    void makeWorkload(std::size_t n, std::vector<std::uint32_t>& pcs, std::vector<std::uint32_t>& opcodes) {
+        pcs.resize(n);
+        opcodes.resize(n);
+        for (std::size_t i = 0; i < n; ++i) {
+            pcs[i] = 0x80000000u + static_cast<std::uint32_t>(4 * i);
+            opcodes[i] = 0x00000013u ^ static_cast<std::uint32_t>(i);
+        }
+    }
+
+    void setRates(benchmark::State& state, std::int64_t instructionsPerIteration) {
+        state.SetItemsProcessed(state.iterations() * instructionsPerIteration); // instructions/s
+        state.SetBytesProcessed(state.iterations() * instructionsPerIteration * 8); // raw format: 8 bytes each
+    }
+}
+
+// Encoder -> funnel -> sink. Circular sink so the ring keeps absorbing data without a drain.
+// Args: sink size (bytes), batch size (1 = emitTrace per instruction, otherwise emitTraceBatch)
+static void BM_PipelineEmit(benchmark::State& state) {
+    const auto sinkBytes = static_cast<std::uint32_t>(state.range(0));
+    const auto batch = static_cast<std::size_t>(state.range(1));
+    std::vector<std::uint32_t> pcs, opcodes;
+    makeWorkload(batch, pcs, opcodes);
+    Rig rig{sinkBytes, TraceRamSink::FullPolicy::Circular};
+
+    for (auto _ : state) {
+        if (batch == 1) {
+            rig.sys.emitTrace(pcs[0], opcodes[0]);
+        } else {
+            rig.sys.emitTraceBatch(pcs.data(), opcodes.data(), batch);
+        }
+    }
+    setRates(state, static_cast<std::int64_t>(batch));
+}
+BENCHMARK(BM_PipelineEmit)->ArgsProduct({{1 << 10, 1 << 16, 1 << 20}, {1, 64, 4096}});
+
+// Drain a full sink through ProbeHwAccess. Arg 0: sink size (bytes), arg 1: 0 = fetch(), 1 = fetchBulk()
+static void BM_PipelineFetch(benchmark::State& state) {
+    const auto sinkBytes = static_cast<std::uint32_t>(state.range(0));
+    const bool bulk = state.range(1) != 0;
+    const std::size_t instructions = sinkBytes / 8;
+    std::vector<std::uint32_t> pcs, opcodes;
+    makeWorkload(instructions, pcs, opcodes);
+    std::vector<std::uint32_t> words(sinkBytes / 4);
+    Rig rig{sinkBytes};
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        rig.sys.emitTraceBatch(pcs.data(), opcodes.data(), instructions); // refill
+        state.ResumeTiming();
+        if (bulk) {
+            benchmark::DoNotOptimize(rig.tci.fetchBulk(words.data(), words.size()));
+        } else {
+            benchmark::DoNotOptimize(rig.tci.fetch(words.size()));
+        }
+    }
+    setRates(state, static_cast<std::int64_t>(instructions));
+}
+BENCHMARK(BM_PipelineFetch)->ArgsProduct({{1 << 10, 1 << 16, 1 << 20}, {0, 1}});
+
+// configure + start + stop through ProbeHwAccess. Arg: verify policy (0 Always, 1 OnConfigure, 2 Never)
+static void BM_PipelineSequence(benchmark::State& state) {
+    const auto policy = static_cast<TraceControllerInterface::VerifyPolicy>(state.range(0));
+    TraceSystem sys{1024};
+    ProbeHwAccess probe{sys.mmioBus, kRegions, ProbeHwAccess::LogMode::Off};
+    TraceControllerInterface tci{probe, TraceSystem::TR_TE_BASE, TraceSystem::TR_FUNNEL_BASE, TraceSystem::TR_RAM_SINK_BASE};
+    tci.setVerifyPolicy(policy);
+
+    std::uint64_t transactions = 0;
+    for (auto _ : state) {
+        tci.configure();
+        transactions += tci.lastSequenceStats().reads + tci.lastSequenceStats().writes;
+        tci.start();
+        transactions += tci.lastSequenceStats().reads + tci.lastSequenceStats().writes;
+        tci.stop();
+        transactions += tci.lastSequenceStats().reads + tci.lastSequenceStats().writes;
+    }
+    state.SetItemsProcessed(state.iterations()); // sequences/s
+    state.counters["probe_transactions"] = benchmark::Counter(static_cast<double>(transactions) / state.iterations());
+}
+BENCHMARK(BM_PipelineSequence)->DenseRange(0, 2);
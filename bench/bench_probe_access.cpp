@@ -0,0 +1,48 @@
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <vector>
+
+#include "TraceSystem.h"
+#include "ProbeHwAccess.h"
+#include "TraceControlRegisters.h"
+
+using namespace tci;
+
+namespace {
+    const std::vector<ProbeHwAccess::ComponentRegion> kRegions = {
+        {TraceSystem::TR_TE_BASE,       0x1000, "TraceEncoder"},
+        {TraceSystem::TR_FUNNEL_BASE,   0x1000, "TraceFunnel"},
+        {TraceSystem::TR_RAM_SINK_BASE, 0x1000, "TraceRamSink"}
+    };
+
+    void runProbeRead(benchmark::State& state, ProbeHwAccess::LogMode mode) {
+        TraceSystem sys{1024};
+        ProbeHwAccess probe{sys.mmioBus, kRegions, mode};
+        const std::uint32_t address = TraceSystem::TR_RAM_SINK_BASE + tr_ram::TR_RAM_WP_LOW;
+        for (auto _ : state) {
+            benchmark::DoNotOptimize(probe.ReadMemory(address));
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+}
+
+// Baseline: the bus without a probe in front of it
+static void BM_ProbeReadBusOnly(benchmark::State& state) {
+    TraceSystem sys{1024};
+    const std::uint32_t address = TraceSystem::TR_RAM_SINK_BASE + tr_ram::TR_RAM_WP_LOW;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(sys.mmioBus.read32(address));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ProbeReadBusOnly);
+
+static void BM_ProbeReadLogOff(benchmark::State& state) {
+    runProbeRead(state, ProbeHwAccess::LogMode::Off);
+}
+BENCHMARK(BM_ProbeReadLogOff);
+
+static void BM_ProbeReadLogBinary(benchmark::State& state) {
+    runProbeRead(state, ProbeHwAccess::LogMode::Binary);
+}
+BENCHMARK(BM_ProbeReadLogBinary);
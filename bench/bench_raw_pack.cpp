@@ -0,0 +1,68 @@
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+#include "RawPackKernels.h"
+
+using namespace tci;
+
+namespace {
+    constexpr std::size_t kRecords = 1 << 14; // 128 KB of raw trace, stays in L2
+
+    void makeRecords(std::vector<std::uint32_t>& pcs, std::vector<std::uint32_t>& opcodes) {
+        pcs.resize(kRecords);
+        opcodes.resize(kRecords);
+        for (std::size_t i = 0; i < kRecords; ++i) {
+            pcs[i] = 0x80000000u + static_cast<std::uint32_t>(4 * i);
+            opcodes[i] = 0x00000013u ^ static_cast<std::uint32_t>(i);
+        }
+    }
+}
+
+// Encode: pcs/opcodes -> raw bytes. Arg: simd::Level (0 = byte-wise scalar reference, 1 = SSE2, 2 = AVX2)
+static void BM_RawPack(benchmark::State& state) {
+    const auto level = static_cast<simd::Level>(state.range(0));
+    if (level > simd::bestLevel()) {
+        state.SkipWithError("SIMD level not supported by this CPU");
+        return;
+    }
+    std::vector<std::uint32_t> pcs, opcodes;
+    makeRecords(pcs, opcodes);
+    std::vector<std::uint8_t> out(8 * kRecords);
+
+    for (auto _ : state) {
+        simd::packRaw(pcs.data(), opcodes.data(), kRecords, out.data(), level);
+        benchmark::DoNotOptimize(out.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(8 * kRecords));
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(kRecords));
+}
+BENCHMARK(BM_RawPack)->DenseRange(0, 2);
+
+// Decode: fetched words -> separate pc/opcode arrays
+static void BM_RawUnpack(benchmark::State& state) {
+    const auto level = static_cast<simd::Level>(state.range(0));
+    if (level > simd::bestLevel()) {
+        state.SkipWithError("SIMD level not supported by this CPU");
+        return;
+    }
+    std::vector<std::uint32_t> pcs, opcodes;
+    makeRecords(pcs, opcodes);
+    std::vector<std::uint32_t> words(2 * kRecords);
+    for (std::size_t i = 0; i < kRecords; ++i) {
+        words[2 * i] = pcs[i];
+        words[2 * i + 1] = opcodes[i];
+    }
+
+    for (auto _ : state) {
+        simd::unpackRaw(words.data(), kRecords, pcs.data(), opcodes.data(), level);
+        benchmark::DoNotOptimize(pcs.data());
+        benchmark::DoNotOptimize(opcodes.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(8 * kRecords));
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(kRecords));
+}
+BENCHMARK(BM_RawUnpack)->DenseRange(0, 2);
@@ -0,0 +1,83 @@
+/*
+    Bash Terminal
+        cmake -S . -B build -DTCI_BUILD_BENCH=ON -DCMAKE_BUILD_TYPE=Release
+        cmake --build build --target tci_bench
+        ./build/tci_bench --benchmark_filter=Remote
+*/
+
+#include <benchmark/benchmark.h>
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "TraceSystem.h"
+#include "TraceControllerInterface.h"
+#include "ProbeServer.h"
+#include "RemoteHwAccess.h"
+
+using namespace tci;
+
+namespace {
+    // TraceSystem behind a ProbeServer (Unix socket), controller on a RemoteHwAccess client
+    struct RemoteRig {
+        RemoteRig(std::uint32_t sinkBytes, std::chrono::microseconds roundTrip, bool posted)
+            : sys(sinkBytes), server(sys.mmioBus), path(socketPath()), remote(listen(path)),
+              tci(remote, TraceSystem::TR_TE_BASE, TraceSystem::TR_FUNNEL_BASE, TraceSystem::TR_RAM_SINK_BASE) {
+            server.setRoundTripDelay(roundTrip);
+            remote.setPostedWrites(posted);
+        }
+
+        static std::string socketPath() { return "/tmp/tci_bench_probe.sock"; }
+        const std::string& listen(const std::string& p) { server.listenUnix(p); return p; }
+
+        TraceSystem sys;
+        ProbeServer server;
+        std::string path;
+        RemoteHwAccess remote;
+        TraceControllerInterface tci;
+    };
+}
+
+// configure + start + stop over the socket. Args: simulated round-trip (us), posted writes (0/1), verify policy.
+// Reports the probe round-trips per sequence set; wall time follows round-trips x latency.
+static void BM_RemoteSequence(benchmark::State& state) {
+    RemoteRig rig{1024, std::chrono::microseconds(state.range(0)), state.range(1) != 0};
+    rig.tci.setVerifyPolicy(static_cast<TraceControllerInterface::VerifyPolicy>(state.range(2)));
+
+    const std::uint64_t before = rig.remote.roundTrips();
+    for (auto _ : state) {
+        rig.tci.configure();
+        rig.tci.start();
+        rig.tci.stop();
+        rig.remote.flush(); // posted writes complete within the measured sequence
+    }
+    state.SetItemsProcessed(state.iterations()); // sequences/s
+    state.counters["round_trips"] = benchmark::Counter(static_cast<double>(rig.remote.roundTrips() - before) / state.iterations());
+}
+BENCHMARK(BM_RemoteSequence)->ArgsProduct({{0, 100}, {0, 1}, {0, 2}})->UseRealTime();
+
+// Drain a full sink with fetchBulk over the socket. Args: sink size (bytes), simulated round-trip (us).
+static void BM_RemoteFetch(benchmark::State& state) {
+    const auto sinkBytes = static_cast<std::uint32_t>(state.range(0));
+    RemoteRig rig{sinkBytes, std::chrono::microseconds(state.range(1)), false};
+    rig.tci.setVerifyPolicy(TraceControllerInterface::VerifyPolicy::Never);
+    rig.tci.configure();
+    rig.tci.start();
+
+    const std::size_t instructions = sinkBytes / 8;
+    std::vector<std::uint32_t> pcs(instructions), opcodes(instructions, 0x00000013u);
+    for (std::size_t i = 0; i < instructions; ++i) pcs[i] = 0x80000000u + static_cast<std::uint32_t>(4 * i);
+    std::vector<std::uint32_t> words(sinkBytes / 4);
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        rig.sys.emitTraceBatch(pcs.data(), opcodes.data(), instructions); // refill
+        state.ResumeTiming();
+        benchmark::DoNotOptimize(rig.tci.fetchBulk(words.data(), words.size()));
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(instructions));
+    state.SetBytesProcessed(state.iterations() * static_cast<std::int64_t>(sinkBytes));
+}
+BENCHMARK(BM_RemoteFetch)->ArgsProduct({{1 << 12, 1 << 16, 1 << 20}, {0, 100}})->UseRealTime();
@@ -0,0 +1,77 @@
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+#include "TraceEncoder.h"
+#include "TraceControlRegisters.h"
+
+using namespace tci;
+
+namespace {
+    // Downstream stand-in that only counts bytes, so the encoder cost is measured in isolation
+    class CountingConnect : public TraceBytesConnect {
+    public:
+        using TraceBytesConnect::pushBytes;
+        bool pushBytes(const std::uint8_t* data, std::size_t n) override {
+            benchmark::DoNotOptimize(data);
+            bytes += n;
+            return true;
+        }
+        std::size_t bytes = 0;
+    };
+
+    void enableEncoder(TraceEncoder& encoder) {
+        encoder.write32(tr_te::TR_TE_CONTROL,
+                        tr_te::TR_TE_ACTIVE | tr_te::TR_TE_ENABLE | tr_te::TR_TE_INST_TRACING);
+    }
+
+    void makeWorkload(std::size_t n, std::vector<std::uint32_t>& pcs, std::vector<std::uint32_t>& opcodes) {
+        pcs.resize(n);
+        opcodes.resize(n);
+        for (std::size_t i = 0; i < n; ++i) {
+            pcs[i] = 0x80000000u + static_cast<std::uint32_t>(4 * i);
+            opcodes[i] = 0x00000013u ^ static_cast<std::uint32_t>(i); // addi-like
+        }
+    }
+}
+
+// Per-instruction path: one emitTrace (and one pushBytes) per record
+static void BM_EncoderEmitTrace(benchmark::State& state) {
+    const auto n = static_cast<std::size_t>(state.range(0));
+    std::vector<std::uint32_t> pcs, opcodes;
+    makeWorkload(n, pcs, opcodes);
+
+    CountingConnect sinkStub;
+    TraceEncoder encoder;
+    encoder.connect(&sinkStub);
+    enableEncoder(encoder);
+
+    for (auto _ : state) {
+        for (std::size_t i = 0; i < n; ++i) {
+            encoder.emitTrace(pcs[i], opcodes[i]);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(n));
+    state.SetBytesProcessed(static_cast<int64_t>(sinkStub.bytes));
+}
+BENCHMARK(BM_EncoderEmitTrace)->RangeMultiplier(8)->Range(8, 4096);
+
+// Batched path: one emitTraceBatch per n records
+static void BM_EncoderEmitTraceBatch(benchmark::State& state) {
+    const auto n = static_cast<std::size_t>(state.range(0));
+    std::vector<std::uint32_t> pcs, opcodes;
+    makeWorkload(n, pcs, opcodes);
+
+    CountingConnect sinkStub;
+    TraceEncoder encoder;
+    encoder.connect(&sinkStub);
+    enableEncoder(encoder);
+
+    for (auto _ : state) {
+        encoder.emitTraceBatch(pcs.data(), opcodes.data(), n);
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(n));
+    state.SetBytesProcessed(static_cast<int64_t>(sinkStub.bytes));
+}
+BENCHMARK(BM_EncoderEmitTraceBatch)->RangeMultiplier(8)->Range(8, 4096);
@@ -0,0 +1,30 @@
+/*
+    Bash Terminal
+        cmake -S . -B build -DTCI_BUILD_BENCH=ON -DCMAKE_BUILD_TYPE=Release
+        cmake --build build --target tci_bench
+        ./build/tci_bench --benchmark_filter=TraceFarm
+*/
+
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <cstddef>
+
+#include "TraceFarm.h"
+
+using namespace tci;
+
+// Emit + drain on every system of a TraceFarm. Args: systems, worker threads.
+// Reports aggregate instructions/s; scaling with threads shows the systems share no locks.
+static void BM_TraceFarm(benchmark::State& state) {
+    constexpr std::size_t instructions = 1 << 16;
+    TraceFarm farm{static_cast<std::size_t>(state.range(0)), 1u << 16, static_cast<std::size_t>(state.range(1))};
+
+    std::uint64_t words = 0;
+    for (auto _ : state) {
+        words += farm.run(instructions).words;
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(instructions * farm.size()));
+    state.SetBytesProcessed(static_cast<std::int64_t>(4 * words));
+    state.counters["steals"] = benchmark::Counter(static_cast<double>(farm.steals()) / state.iterations());
+}
+BENCHMARK(BM_TraceFarm)->ArgsProduct({{1, 4, 16, 64}, {1, 2, 4, 8}})->UseRealTime()->Unit(benchmark::kMillisecond);
@@ -0,0 +1,130 @@
+#include <benchmark/benchmark.h>
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+#include <random>
+#include <vector>
+
+#include "TraceEncoder.h"
+#include "TraceDecoder.h"
+#include "ThreadPool.h"
+#include "TraceControlRegisters.h"
+
+using namespace tci;
+
+namespace {
+    // Keeps every byte so the decoder can be benchmarked on the same stream
+    class CollectConnect : public TraceBytesConnect {
+    public:
+        using TraceBytesConnect::pushBytes;
+        bool pushBytes(const std::uint8_t* data, std::size_t n) override {
+            bytes.insert(bytes.end(), data, data + n);
+            return true;
+        }
+        std::vector<std::uint8_t> bytes;
+    };
+
+    // Basic blocks of 1..12 sequential instructions ending in a branch within a 256 KB code region
+    std::vector<std::uint32_t> makeControlFlow(std::size_t n) {
+        std::mt19937 rng(7);
+        std::vector<std::uint32_t> pcs;
+        pcs.reserve(n);
+        std::uint32_t pc = 0x80000000u;
+        while (pcs.size() < n) {
+            const std::uint32_t blockLen = 1 + rng() % 12;
+            for (std::uint32_t i = 0; i < blockLen && pcs.size() < n; ++i) {
+                pcs.push_back(pc);
+                pc += 4;
+            }
+            pc = 0x80000000u + ((rng() % 0x40000u) & ~0x3u);
+        }
+        return pcs;
+    }
+
+    void enableEncoder(TraceEncoder& encoder, std::uint32_t format) {
+        encoder.write32(tr_te::TR_TE_CONTROL, tr_te::TR_TE_ACTIVE | tr_te::TR_TE_ENABLE | tr_te::TR_TE_INST_TRACING |
+                                              (format << tr_te::TR_TE_FORMAT_SHIFT));
+    }
+
+    constexpr std::size_t kInstructions = 1 << 16;
+}
+
+// Encode cost per instruction (items_per_second) and compression ratio vs the raw format.
+// Arg: trTeFormat (0 = raw, 6 = delta)
+static void BM_TraceFormatEncode(benchmark::State& state) {
+    const auto format = static_cast<std::uint32_t>(state.range(0));
+    const auto pcs = makeControlFlow(kInstructions);
+    std::vector<std::uint32_t> opcodes(pcs.size(), 0x00000013u);
+
+    CollectConnect out;
+    out.bytes.reserve(kInstructions * 8);
+    TraceEncoder encoder;
+    encoder.connect(&out);
+
+    std::size_t streamBytes = 0;
+    std::int64_t encodeNs = 0;
+    for (auto _ : state) {
+        out.bytes.clear();
+        enableEncoder(encoder, format);
+        const auto t0 = std::chrono::steady_clock::now();
+        encoder.emitTraceBatch(pcs.data(), opcodes.data(), pcs.size());
+        encoder.flush();
+        encodeNs += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - t0).count();
+        streamBytes = out.bytes.size();
+        benchmark::DoNotOptimize(out.bytes.data());
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(pcs.size()));
+    state.counters["ns_per_inst"] = static_cast<double>(encodeNs) / (static_cast<double>(state.iterations()) * pcs.size());
+    state.counters["compression_ratio"] = static_cast<double>(pcs.size() * 8) / static_cast<double>(streamBytes);
+    state.counters["bytes_per_inst"] = static_cast<double>(streamBytes) / static_cast<double>(pcs.size());
+}
+BENCHMARK(BM_TraceFormatEncode)->Arg(tr_te::TR_TE_FORMAT_RAW)->Arg(tr_te::TR_TE_FORMAT_DELTA);
+
+static void BM_TraceFormatDecodeDelta(benchmark::State& state) {
+    const auto pcs = makeControlFlow(kInstructions);
+    std::vector<std::uint32_t> opcodes(pcs.size(), 0x00000013u);
+    CollectConnect out;
+    TraceEncoder encoder;
+    encoder.connect(&out);
+    enableEncoder(encoder, tr_te::TR_TE_FORMAT_DELTA);
+    encoder.emitTraceBatch(pcs.data(), opcodes.data(), pcs.size());
+    encoder.flush();
+
+    TraceDecoder decoder;
+    std::vector<DecodedInstruction> decoded;
+    decoded.reserve(pcs.size());
+    for (auto _ : state) {
+        decoded.clear();
+        decoder.decodeDelta(out.bytes.data(), out.bytes.size(), decoded);
+        benchmark::DoNotOptimize(decoded.data());
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(pcs.size()));
+}
+BENCHMARK(BM_TraceFormatDecodeDelta);
+
+// Parallel decode of a 4M-instruction delta capture with SYNC every 2^(6+4) instructions.
+// Arg: worker threads
+static void BM_TraceFormatDecodeParallel(benchmark::State& state) {
+    constexpr std::size_t instructions = 1 << 22;
+    const auto pcs = makeControlFlow(instructions);
+    std::vector<std::uint32_t> opcodes(pcs.size(), 0x00000013u);
+    CollectConnect out;
+    TraceEncoder encoder;
+    encoder.connect(&out);
+    encoder.write32(tr_te::TR_TE_CONTROL, tr_te::TR_TE_ACTIVE | tr_te::TR_TE_ENABLE | tr_te::TR_TE_INST_TRACING |
+                                          (tr_te::TR_TE_FORMAT_DELTA << tr_te::TR_TE_FORMAT_SHIFT) |
+                                          (2u << tr_te::TR_TE_INST_SYNC_MODE_SHIFT) | (6u << tr_te::TR_TE_INST_SYNC_MAX_SHIFT));
+    encoder.emitTraceBatch(pcs.data(), opcodes.data(), pcs.size());
+    encoder.flush();
+
+    ThreadPool pool{static_cast<std::size_t>(state.range(0))};
+    TraceDecoder decoder;
+    for (auto _ : state) {
+        auto decoded = decoder.decodeParallel(out.bytes.data(), out.bytes.size(), TraceDecoder::Format::Delta, pool,
+                                              true, 64 * 1024);
+        benchmark::DoNotOptimize(decoded.data());
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(pcs.size()));
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(out.bytes.size()));
+}
+BENCHMARK(BM_TraceFormatDecodeParallel)->RangeMultiplier(2)->Range(1, 8)->UseRealTime()->Unit(benchmark::kMillisecond);
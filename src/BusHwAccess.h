@@ -0,0 +1,27 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+#include "IHwAccess.h"
+#include "MmioBus.h"
+
+namespace tci {
+    // Direct MMIO bus access without probe logging or latency: every call goes straight to the bus,
+    // block transfers included. For benches and for tests that poll from a second thread.
+    class BusHwAccess : public IHwAccess {
+    public:
+        explicit BusHwAccess(MmioBus& bus) : bus_(bus) {}
+
+        void WriteMemory(std::uint32_t address, std::uint32_t value) override { bus_.write32(address, value); }
+        std::uint32_t ReadMemory(std::uint32_t address) override { return bus_.read32(address); }
+        void ReadMemoryBlock(std::uint32_t address, std::uint32_t* dst, std::size_t count, bool fixedAddress) override {
+            bus_.readBlock32(address, dst, count, fixedAddress);
+        }
+        void WriteMemoryBlock(std::uint32_t address, const std::uint32_t* src, std::size_t count, bool fixedAddress) override {
+            bus_.writeBlock32(address, src, count, fixedAddress);
+        }
+
+    private:
+        MmioBus& bus_;
+    };
+}
@@ -0,0 +1,104 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <thread>
+#include <stdexcept>
+
+#include "TraceControllerInterface.h"
+
+namespace tci {
+    // Drives the asynchronous controller operations (TraceControllerInterface::asyncBegin/asyncStep) of
+    // many systems from one thread. Each controller gets a script of operations that run in order;
+    // run() round-robins over the controllers, starting the next operation of an idle one and stepping
+    // those whose probe finished a batch, so the probe round-trips of all systems overlap.
+    class ControllerScheduler {
+    public:
+        using Operation = TraceControllerInterface::Operation;
+
+        // One scripted operation. Fetch drains into dst (up to maxWords); fetched is set when it completes.
+        struct Step {
+            Step(Operation operation) : op(operation) {}
+
+            static Step fetch(std::uint32_t* dst, std::size_t maxWords) {
+                Step step(Operation::Fetch);
+                step.dst = dst;
+                step.maxWords = maxWords;
+                return step;
+            }
+
+            Operation op;
+            std::uint32_t* dst = nullptr;
+            std::size_t maxWords = 0;
+            std::size_t fetched = 0;
+        };
+
+        // Returns the script index (see script()). The controller must stay alive until run() returns.
+        std::size_t add(TraceControllerInterface& controller, std::vector<Step> script) {
+            if (controller.asyncBusy()) throw std::logic_error("ControllerScheduler: controller has an operation in flight");
+            tasks_.push_back({&controller, std::move(script), 0, false});
+            return tasks_.size() - 1;
+        }
+
+        // Run every script to completion. An exception from a controller ends the run and is rethrown;
+        // other controllers may be left with an operation in flight.
+        void run() {
+            std::size_t remaining = 0;
+            for (const Task& t : tasks_) remaining += (t.next < t.script.size());
+            while (remaining != 0) {
+                bool progress = false;
+                for (Task& t : tasks_) {
+                    if (t.next == t.script.size()) continue;
+                    Step& step = t.script[t.next];
+                    if (!t.running) {
+                        t.controller->asyncBegin(step.op, step.dst, step.maxWords);
+                        t.running = true;
+                        if (++inFlight_ > maxInFlight_) maxInFlight_ = inFlight_;
+                        progress = true;
+                        continue;
+                    }
+                    if (!t.controller->asyncReady()) continue;
+                    ++steps_;
+                    progress = true;
+                    if (!t.controller->asyncStep()) continue;
+                    if (step.op == Operation::Fetch) step.fetched = t.controller->asyncFetched();
+                    t.running = false;
+                    --inFlight_;
+                    if (++t.next == t.script.size()) --remaining;
+                }
+                if (!progress) {
+                    ++idlePasses_;
+                    std::this_thread::yield();
+                }
+            }
+        }
+
+        const std::vector<Step>& script(std::size_t index) const { return tasks_.at(index).script; }
+
+        // Drop all scripts (e.g. to schedule the next phase for the same controllers)
+        void clear() {
+            tasks_.clear();
+            inFlight_ = 0;
+        }
+
+        // Statistics: probe batches completed, passes in which no probe was ready, and the most operations
+        // in flight at once (each has one probe batch outstanding, so that many round-trips overlapped)
+        std::uint64_t steps() const { return steps_; }
+        std::uint64_t idlePasses() const { return idlePasses_; }
+        std::size_t maxInFlight() const { return maxInFlight_; }
+
+    private:
+        struct Task {
+            TraceControllerInterface* controller;
+            std::vector<Step> script;
+            std::size_t next;
+            bool running; // script[next] started
+        };
+
+        std::vector<Task> tasks_;
+        std::uint64_t steps_ = 0;
+        std::uint64_t idlePasses_ = 0;
+        std::size_t inFlight_ = 0;
+        std::size_t maxInFlight_ = 0;
+    };
+}
@@ -1,14 +1,53 @@
-#pragma once
-#include <cstdint>
-
-namespace tci {
-
-// Probe/tool hardware-access abstraction (only allowed access path for controller)
-class IHwAccess {
-public:
-    virtual ~IHwAccess() = default;
-    virtual void WriteMemory(std::uint32_t address, std::uint32_t value) = 0;
-    virtual std::uint32_t ReadMemory(std::uint32_t address) = 0;
-};
-
-} // namespace tci
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+namespace tci {
+
+// Probe/tool hardware-access abstraction (only allowed access path for controller)
+class IHwAccess {
+public:
+    virtual ~IHwAccess() = default;
+    virtual void WriteMemory(std::uint32_t address, std::uint32_t value) = 0;
+    virtual std::uint32_t ReadMemory(std::uint32_t address) = 0;
+
+    // Block transfers of count 32-bit words.
+    // fixedAddress = true: every word uses the same address (FIFO-style register, e.g. TR_RAM_DATA)
+    // fixedAddress = false: address increments by 4 per word
+    // Default falls back to one ReadMemory/WriteMemory per word; probes with burst support override.
+    virtual void ReadMemoryBlock(std::uint32_t address, std::uint32_t* dst, std::size_t count, bool fixedAddress) {
+        for (std::size_t i = 0; i < count; ++i) {
+            dst[i] = ReadMemory(fixedAddress ? address : address + static_cast<std::uint32_t>(4 * i));
+        }
+    }
+    virtual void WriteMemoryBlock(std::uint32_t address, const std::uint32_t* src, std::size_t count, bool fixedAddress) {
+        for (std::size_t i = 0; i < count; ++i) {
+            WriteMemory(fixedAddress ? address : address + static_cast<std::uint32_t>(4 * i), src[i]);
+        }
+    }
+
+    // Deferred accesses: queued in order and executed no later than the next Flush(), so a probe can
+    // run a whole sequence in one scan/round-trip. A queued read stores its value in *dst once Flush()
+    // returns (dst must stay valid until then); a queued block write copies src. Immediate accesses
+    // keep program order with everything queued before them.
+    // Default: every access executes right away and Flush() has nothing left to do.
+    virtual void QueueWrite(std::uint32_t address, std::uint32_t value) { WriteMemory(address, value); }
+    virtual void QueueRead(std::uint32_t address, std::uint32_t* dst) { *dst = ReadMemory(address); }
+    virtual void QueueReadBlock(std::uint32_t address, std::uint32_t* dst, std::size_t count, bool fixedAddress) {
+        ReadMemoryBlock(address, dst, count, fixedAddress);
+    }
+    virtual void QueueWriteBlock(std::uint32_t address, const std::uint32_t* src, std::size_t count, bool fixedAddress) {
+        WriteMemoryBlock(address, src, count, fixedAddress);
+    }
+    virtual void Flush() {}
+
+    // Split-phase flush, for one thread overlapping the latency of several probes:
+    // BeginFlush() starts executing the queue, FlushReady() tells whether EndFlush() would return
+    // without waiting, EndFlush() completes the flush (queued reads are valid). Nothing may be queued
+    // or accessed in between. Default: the whole flush happens in EndFlush().
+    virtual void BeginFlush() {}
+    virtual bool FlushReady() { return true; }
+    virtual void EndFlush() { Flush(); }
+};
+
+} // namespace tci
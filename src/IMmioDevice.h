@@ -1,17 +1,31 @@
-
-#pragma once
-#include <cstdint>
-
-namespace tci {
-
-    class IMmioDevice
-    {
-    public:
-        virtual ~IMmioDevice() = default;
-
-        // offset is within the device's address space, not the global address space
-        virtual std::uint32_t read32(std::uint32_t offset) = 0;
-        virtual void write32(std::uint32_t offset, std::uint32_t value) = 0;
-    };
-
+
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+namespace tci {
+
+    class IMmioDevice
+    {
+    public:
+        virtual ~IMmioDevice() = default;
+
+        // offset is within the device's address space, not the global address space
+        virtual std::uint32_t read32(std::uint32_t offset) = 0;
+        virtual void write32(std::uint32_t offset, std::uint32_t value) = 0;
+
+        // Block access of count words; fixedOffset = true repeats the same offset (FIFO-style register).
+        // Default loops over read32/write32; devices with a cheaper bulk path override these.
+        virtual void readBlock32(std::uint32_t offset, std::uint32_t* dst, std::size_t count, bool fixedOffset) {
+            for (std::size_t i = 0; i < count; ++i) {
+                dst[i] = read32(fixedOffset ? offset : offset + static_cast<std::uint32_t>(4 * i));
+            }
+        }
+        virtual void writeBlock32(std::uint32_t offset, const std::uint32_t* src, std::size_t count, bool fixedOffset) {
+            for (std::size_t i = 0; i < count; ++i) {
+                write32(fixedOffset ? offset : offset + static_cast<std::uint32_t>(4 * i), src[i]);
+            }
+        }
+    };
+
 }
\ No newline at end of file
@@ -0,0 +1,165 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <cassert>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "IHwAccess.h"
+
+namespace tci {
+    // IHwAccess decorator that models a probe with a fixed round-trip latency, for measuring how
+    // access sequences scale with the transport. Every immediate access costs one round-trip; queued
+    // accesses are held until Flush() and then cost one round-trip for the whole batch, like a probe
+    // executing its queue in one scan. The split-phase flush starts the round-trip in BeginFlush(), so
+    // several LatencyHwAccess instances wait concurrently on one thread. With queueing disabled the queued calls behave like immediate
+    // ones (one round-trip each), which is what a strictly synchronous probe does.
+    class LatencyHwAccess : public IHwAccess {
+    public:
+        LatencyHwAccess(IHwAccess& inner, std::chrono::microseconds roundTrip, bool queueing = true)
+            : inner_(inner), roundTrip_(roundTrip), queueing_(queueing) {}
+
+        void setRoundTrip(std::chrono::microseconds roundTrip) { roundTrip_ = roundTrip; }
+        void setQueueing(bool queueing) {
+            Flush();
+            queueing_ = queueing;
+        }
+
+        void WriteMemory(std::uint32_t address, std::uint32_t value) override {
+            immediate();
+            inner_.WriteMemory(address, value);
+        }
+
+        std::uint32_t ReadMemory(std::uint32_t address) override {
+            immediate();
+            return inner_.ReadMemory(address);
+        }
+
+        void ReadMemoryBlock(std::uint32_t address, std::uint32_t* dst, std::size_t count, bool fixedAddress) override {
+            immediate();
+            inner_.ReadMemoryBlock(address, dst, count, fixedAddress);
+        }
+
+        void WriteMemoryBlock(std::uint32_t address, const std::uint32_t* src, std::size_t count, bool fixedAddress) override {
+            immediate();
+            inner_.WriteMemoryBlock(address, src, count, fixedAddress);
+        }
+
+        void QueueWrite(std::uint32_t address, std::uint32_t value) override {
+            assert(!inFlight_);
+            if (!queueing_) return WriteMemory(address, value);
+            queue_.push_back({Write, address, value, nullptr, 0, false});
+        }
+
+        void QueueRead(std::uint32_t address, std::uint32_t* dst) override {
+            assert(!inFlight_);
+            if (!queueing_) { *dst = ReadMemory(address); return; }
+            queue_.push_back({Read, address, 0, dst, 1, false});
+        }
+
+        void QueueReadBlock(std::uint32_t address, std::uint32_t* dst, std::size_t count, bool fixedAddress) override {
+            assert(!inFlight_);
+            if (!queueing_) return ReadMemoryBlock(address, dst, count, fixedAddress);
+            queue_.push_back({ReadBlock, address, 0, dst, count, fixedAddress});
+        }
+
+        void QueueWriteBlock(std::uint32_t address, const std::uint32_t* src, std::size_t count, bool fixedAddress) override {
+            assert(!inFlight_);
+            if (!queueing_) return WriteMemoryBlock(address, src, count, fixedAddress);
+            const std::size_t at = writeData_.size();
+            writeData_.insert(writeData_.end(), src, src + count);
+            queue_.push_back({WriteBlock, address, static_cast<std::uint32_t>(at), nullptr, count, fixedAddress});
+        }
+
+        // One round-trip for everything queued, then the accesses run in order on the inner probe
+        void Flush() override {
+            if (queue_.empty()) return;
+            roundTrip();
+            execute();
+        }
+
+        void BeginFlush() override {
+            if (queue_.empty() || inFlight_) return;
+            ++roundTrips_;
+            deadline_ = std::chrono::steady_clock::now() + roundTrip_;
+            inFlight_ = true;
+        }
+
+        bool FlushReady() override { return !inFlight_ || std::chrono::steady_clock::now() >= deadline_; }
+
+        void EndFlush() override {
+            if (!inFlight_) return Flush();
+            inFlight_ = false;
+            waitUntil(deadline_);
+            execute();
+        }
+
+        // Statistics: round-trips paid (immediate accesses + non-empty flushes) and accesses executed
+        std::uint64_t roundTrips() const { return roundTrips_; }
+        std::uint64_t accesses() const { return accesses_; }
+
+    private:
+        enum Op : std::uint8_t { Write, Read, ReadBlock, WriteBlock };
+
+        struct Access {
+            Op op;
+            std::uint32_t address;
+            std::uint32_t value; // Write: value, WriteBlock: offset into writeData_
+            std::uint32_t* dst;
+            std::size_t count;
+            bool fixed;
+        };
+
+        // Run the queue in order on the inner probe; the queue is dropped if an access throws
+        void execute() {
+            try {
+                for (const Access& a : queue_) {
+                    switch (a.op) {
+                        case Write:      inner_.WriteMemory(a.address, a.value); break;
+                        case Read:       *a.dst = inner_.ReadMemory(a.address); break;
+                        case ReadBlock:  inner_.ReadMemoryBlock(a.address, a.dst, a.count, a.fixed); break;
+                        case WriteBlock: inner_.WriteMemoryBlock(a.address, writeData_.data() + a.value, a.count, a.fixed); break;
+                    }
+                }
+            } catch (...) {
+                clearQueue();
+                throw;
+            }
+            clearQueue();
+        }
+
+        void immediate() {
+            assert(!inFlight_); // EndFlush() first
+            Flush();
+            roundTrip();
+            ++accesses_;
+        }
+
+        // Busy-waits: sleep granularity is far coarser than typical probe round-trips
+        void roundTrip() {
+            ++roundTrips_;
+            if (roundTrip_.count() > 0) waitUntil(std::chrono::steady_clock::now() + roundTrip_);
+        }
+
+        static void waitUntil(std::chrono::steady_clock::time_point until) {
+            while (std::chrono::steady_clock::now() < until) std::this_thread::yield();
+        }
+
+        void clearQueue() {
+            accesses_ += queue_.size();
+            queue_.clear();
+            writeData_.clear();
+        }
+
+        IHwAccess& inner_;
+        std::chrono::microseconds roundTrip_;
+        bool queueing_;
+        bool inFlight_ = false; // BeginFlush() started the round-trip
+        std::chrono::steady_clock::time_point deadline_;
+        std::vector<Access> queue_;
+        std::vector<std::uint32_t> writeData_; // queued block-write payloads
+        std::uint64_t roundTrips_ = 0;
+        std::uint64_t accesses_ = 0;
+    };
+}
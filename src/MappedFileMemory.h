@@ -0,0 +1,119 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <stdexcept>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace tci {
+
+    // File-backed memory region (mmap / MapViewOfFile).
+    // Used as SMEM backing store for TraceRamSink so the OS can page capture data out,
+    // and by post-processing tools to open a capture zero-copy.
+    class MappedFileMemory {
+    public:
+        // Create (or resize) a file of `size` bytes and map it read-write
+        MappedFileMemory(const std::string& path, std::uint64_t size) : size_(size), writable_(true) {
+            if (size == 0) throw std::invalid_argument("MappedFileMemory size must be non-zero");
+            map(path, true);
+        }
+
+        // Map an existing file read-only (size taken from the file)
+        explicit MappedFileMemory(const std::string& path) : writable_(false) {
+            map(path, false);
+        }
+
+        ~MappedFileMemory() { unmap(); }
+
+        MappedFileMemory(const MappedFileMemory&) = delete;
+        MappedFileMemory& operator=(const MappedFileMemory&) = delete;
+
+        // Read-only mappings (writable() == false) must not be written through data()
+        std::uint8_t* data() { return data_; }
+        const std::uint8_t* data() const { return data_; }
+        std::uint64_t size() const { return size_; }
+        bool writable() const { return writable_; }
+
+    private:
+#if defined(_WIN32)
+        void map(const std::string& path, bool create) {
+            file_ = CreateFileA(path.c_str(), create ? (GENERIC_READ | GENERIC_WRITE) : GENERIC_READ,
+                                FILE_SHARE_READ, nullptr, create ? OPEN_ALWAYS : OPEN_EXISTING,
+                                FILE_ATTRIBUTE_NORMAL, nullptr);
+            if (file_ == INVALID_HANDLE_VALUE) throw std::runtime_error("MappedFileMemory: cannot open " + path);
+            if (!create) {
+                LARGE_INTEGER fileSize;
+                GetFileSizeEx(file_, &fileSize);
+                size_ = static_cast<std::uint64_t>(fileSize.QuadPart);
+                if (size_ == 0) { unmap(); throw std::runtime_error("MappedFileMemory: empty file " + path); }
+            }
+            mapping_ = CreateFileMappingA(file_, nullptr, create ? PAGE_READWRITE : PAGE_READONLY,
+                                          static_cast<DWORD>(size_ >> 32), static_cast<DWORD>(size_), nullptr);
+            if (!mapping_) { unmap(); throw std::runtime_error("MappedFileMemory: cannot map " + path); }
+            data_ = static_cast<std::uint8_t*>(MapViewOfFile(mapping_, create ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, 0));
+            if (!data_) { unmap(); throw std::runtime_error("MappedFileMemory: cannot map " + path); }
+        }
+
+        void unmap() {
+            if (data_) UnmapViewOfFile(data_);
+            if (mapping_) CloseHandle(mapping_);
+            if (file_ != INVALID_HANDLE_VALUE) CloseHandle(file_);
+            data_ = nullptr;
+            mapping_ = nullptr;
+            file_ = INVALID_HANDLE_VALUE;
+        }
+
+        HANDLE file_ = INVALID_HANDLE_VALUE;
+        HANDLE mapping_ = nullptr;
+#else
+        void map(const std::string& path, bool create) {
+            fd_ = create ? ::open(path.c_str(), O_RDWR | O_CREAT, 0644) : ::open(path.c_str(), O_RDONLY);
+            if (fd_ < 0) throw std::runtime_error("MappedFileMemory: cannot open " + path);
+            if (create) {
+                if (::ftruncate(fd_, static_cast<off_t>(size_)) != 0) {
+                    unmap();
+                    throw std::runtime_error("MappedFileMemory: cannot resize " + path);
+                }
+            } else {
+                struct stat st {};
+                if (::fstat(fd_, &st) != 0 || st.st_size == 0) {
+                    unmap();
+                    throw std::runtime_error("MappedFileMemory: cannot stat or empty file " + path);
+                }
+                size_ = static_cast<std::uint64_t>(st.st_size);
+            }
+            void* p = ::mmap(nullptr, static_cast<std::size_t>(size_), create ? (PROT_READ | PROT_WRITE) : PROT_READ,
+                             MAP_SHARED, fd_, 0);
+            if (p == MAP_FAILED) {
+                unmap();
+                throw std::runtime_error("MappedFileMemory: cannot map " + path);
+            }
+            data_ = static_cast<std::uint8_t*>(p);
+        }
+
+        void unmap() {
+            if (data_) ::munmap(data_, static_cast<std::size_t>(size_));
+            if (fd_ >= 0) ::close(fd_);
+            data_ = nullptr;
+            fd_ = -1;
+        }
+
+        int fd_ = -1;
+#endif
+
+        std::uint8_t* data_ = nullptr;
+        std::uint64_t size_ = 0;
+        bool writable_ = false;
+    };
+}
@@ -1,42 +1,177 @@
-#pragma once
-#include <cstdint>
-#include <vector>
-#include <stdexcept>
-#include "IMmioDevice.h"
-
-namespace tci {
-    struct MmioMapping {
-        uint32_t baseAddress;
-        uint32_t size;
-        IMmioDevice* device;
-    };
-
-    class MmioBus {
-        public:
-        void addMapping(uint32_t baseAddress, uint32_t size, IMmioDevice* device) {
-            mappings_.push_back({baseAddress, size, device});
-        }
-        
-        uint32_t read32(uint32_t address) {
-            for (const auto& mapping : mappings_) {
-                if (address >= mapping.baseAddress && address < mapping.baseAddress + mapping.size) {
-                    return mapping.device->read32(address - mapping.baseAddress);
-                }
-            }
-            throw std::out_of_range("MMIO read out of range");
-        }
-        
-        void write32(uint32_t address, uint32_t value) {
-            for (const auto& mapping : mappings_) {
-                if (address >= mapping.baseAddress && address < mapping.baseAddress + mapping.size) {
-                    mapping.device->write32(address - mapping.baseAddress, value); // global to local offset
-                    return;
-                }
-            }
-            throw std::out_of_range("MMIO write out of range");
-        }
-
-        private:
-        std::vector<MmioMapping> mappings_;
-    };
-}
\ No newline at end of file
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <array>
+#include <memory>
+#include <algorithm>
+#include <stdexcept>
+#include "IMmioDevice.h"
+
+namespace tci {
+    struct MmioMapping {
+        uint32_t baseAddress;
+        uint32_t size;
+        IMmioDevice* device;
+    };
+
+    class MmioBus {
+        public:
+        // Linear: scan every mapping on each access (original behavior, kept for comparison)
+        // Indexed: page table lookup on 4 KB granules, binary search for irregular pages
+        enum class DecodeMode { Linear, Indexed };
+
+        static constexpr uint32_t PAGE_SHIFT = 12; // 4 KB granule (matches TraceSystem::COMPONENT_SIZE)
+        static constexpr uint32_t PAGE_SIZE = 1u << PAGE_SHIFT;
+
+        void addMapping(uint32_t baseAddress, uint32_t size, IMmioDevice* device) {
+            if (size == 0 || device == nullptr) {
+                throw std::invalid_argument("MMIO mapping must have a non-zero size and a device");
+            }
+            const uint64_t end = static_cast<uint64_t>(baseAddress) + size;
+            if (end > (uint64_t{1} << 32)) {
+                throw std::invalid_argument("MMIO mapping exceeds 32-bit address space");
+            }
+
+            // Keep mappings_ sorted by base address; overlap only possible with direct neighbours
+            auto it = std::upper_bound(mappings_.begin(), mappings_.end(), baseAddress,
+                [](uint32_t addr, const MmioMapping& m) { return addr < m.baseAddress; });
+            if (it != mappings_.end() && end > it->baseAddress) {
+                throw std::invalid_argument("MMIO mapping overlaps an existing mapping");
+            }
+            if (it != mappings_.begin()) {
+                const auto& prev = *(it - 1);
+                if (static_cast<uint64_t>(prev.baseAddress) + prev.size > baseAddress) {
+                    throw std::invalid_argument("MMIO mapping overlaps an existing mapping");
+                }
+            }
+            // Checked before inserting, so a rejected mapping leaves the bus unchanged
+            if (mappings_.size() + 1 >= IRREGULAR) {
+                throw std::length_error("Too many MMIO mappings for the page index");
+            }
+            const bool append = (it == mappings_.end());
+            it = mappings_.insert(it, {baseAddress, size, device});
+
+            try {
+                // Appending keeps every other index, so only the new mapping's pages change
+                if (append) indexMapping(mappings_.size() - 1);
+                else rebuildIndex();
+            } catch (...) {
+                mappings_.erase(it);
+                rebuildIndex();
+                throw;
+            }
+        }
+
+        void setDecodeMode(DecodeMode mode) { mode_ = mode; }
+        DecodeMode decodeMode() const { return mode_; }
+
+        uint32_t read32(uint32_t address) {
+            const MmioMapping* mapping = find(address);
+            if (!mapping) throw std::out_of_range("MMIO read out of range");
+            return mapping->device->read32(address - mapping->baseAddress);
+        }
+
+        void write32(uint32_t address, uint32_t value) {
+            const MmioMapping* mapping = find(address);
+            if (!mapping) throw std::out_of_range("MMIO write out of range");
+            mapping->device->write32(address - mapping->baseAddress, value); // global to local offset
+        }
+
+        // Block access: decoded once, then handed to the device in a single call.
+        // A non-fixed block must lie entirely within one mapping.
+        void readBlock32(uint32_t address, uint32_t* dst, std::size_t count, bool fixedAddress) {
+            if (count == 0) return;
+            const MmioMapping* mapping = findBlock(address, count, fixedAddress);
+            if (!mapping) throw std::out_of_range("MMIO block read out of range");
+            mapping->device->readBlock32(address - mapping->baseAddress, dst, count, fixedAddress);
+        }
+
+        void writeBlock32(uint32_t address, const uint32_t* src, std::size_t count, bool fixedAddress) {
+            if (count == 0) return;
+            const MmioMapping* mapping = findBlock(address, count, fixedAddress);
+            if (!mapping) throw std::out_of_range("MMIO block write out of range");
+            mapping->device->writeBlock32(address - mapping->baseAddress, src, count, fixedAddress);
+        }
+
+        // Returns the mapping containing address, or nullptr if unmapped
+        const MmioMapping* find(uint32_t address) const {
+            return (mode_ == DecodeMode::Indexed) ? findIndexed(address) : findLinear(address);
+        }
+
+        private:
+        const MmioMapping* findBlock(uint32_t address, std::size_t count, bool fixedAddress) const {
+            const MmioMapping* mapping = find(address);
+            if (!mapping || fixedAddress) return mapping;
+            const uint64_t lastByte = static_cast<uint64_t>(address - mapping->baseAddress) + 4 * static_cast<uint64_t>(count) - 1;
+            return (lastByte < mapping->size) ? mapping : nullptr;
+        }
+
+        // Two-level page table: 1024 directory entries x 1024 leaf entries x 4 KB pages = 4 GB
+        static constexpr uint32_t LEAF_BITS = 10;
+        static constexpr uint32_t LEAF_ENTRIES = 1u << LEAF_BITS;
+        static constexpr uint32_t DIR_ENTRIES = 1u << (32 - PAGE_SHIFT - LEAF_BITS);
+
+        // Leaf entry encoding: 0 = unmapped, IRREGULAR = page shared by several mappings or
+        // only partly covered (fall back to binary search), otherwise mapping index + 1
+        static constexpr uint16_t UNMAPPED = 0;
+        static constexpr uint16_t IRREGULAR = 0xFFFF;
+        using PageLeaf = std::array<uint16_t, LEAF_ENTRIES>;
+
+        const MmioMapping* findLinear(uint32_t address) const {
+            for (const auto& mapping : mappings_) {
+                if (address >= mapping.baseAddress && address - mapping.baseAddress < mapping.size) {
+                    return &mapping;
+                }
+            }
+            return nullptr;
+        }
+
+        const MmioMapping* findIndexed(uint32_t address) const {
+            const PageLeaf* leaf = pageDir_[address >> (PAGE_SHIFT + LEAF_BITS)].get();
+            if (!leaf) return nullptr;
+            const uint16_t entry = (*leaf)[(address >> PAGE_SHIFT) & (LEAF_ENTRIES - 1)];
+            if (entry == UNMAPPED) return nullptr;
+            if (entry != IRREGULAR) return &mappings_[entry - 1];
+            return findSorted(address);
+        }
+
+        // Binary search over mappings_ (sorted by base, non-overlapping)
+        const MmioMapping* findSorted(uint32_t address) const {
+            auto it = std::upper_bound(mappings_.begin(), mappings_.end(), address,
+                [](uint32_t addr, const MmioMapping& m) { return addr < m.baseAddress; });
+            if (it == mappings_.begin()) return nullptr;
+            --it;
+            return (address - it->baseAddress < it->size) ? &*it : nullptr;
+        }
+
+        void rebuildIndex() {
+            for (auto& leaf : pageDir_) leaf.reset();
+            for (std::size_t i = 0; i < mappings_.size(); ++i) indexMapping(i);
+        }
+
+        // Enter mapping i into the pages it touches
+        void indexMapping(std::size_t i) {
+            const auto& m = mappings_[i];
+            const uint64_t end = static_cast<uint64_t>(m.baseAddress) + m.size;
+            const uint32_t firstPage = m.baseAddress >> PAGE_SHIFT;
+            const uint32_t lastPage = static_cast<uint32_t>((end - 1) >> PAGE_SHIFT);
+            for (uint32_t page = firstPage; page <= lastPage; ++page) {
+                const uint64_t pageBase = static_cast<uint64_t>(page) << PAGE_SHIFT;
+                const bool fullyCovered = (pageBase >= m.baseAddress) && (pageBase + PAGE_SIZE <= end);
+
+                auto& leaf = pageDir_[page >> LEAF_BITS];
+                if (!leaf) {
+                    leaf = std::make_unique<PageLeaf>();
+                    leaf->fill(UNMAPPED);
+                }
+                uint16_t& entry = (*leaf)[page & (LEAF_ENTRIES - 1)];
+                entry = (fullyCovered && entry == UNMAPPED) ? static_cast<uint16_t>(i + 1) : IRREGULAR;
+            }
+        }
+
+        private:
+        std::vector<MmioMapping> mappings_; // sorted by baseAddress
+        std::array<std::unique_ptr<PageLeaf>, DIR_ENTRIES> pageDir_{};
+        DecodeMode mode_ = DecodeMode::Indexed;
+    };
+}
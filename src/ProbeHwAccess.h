@@ -1,111 +1,199 @@
-#pragma once
-#include <cstdint>
-#include <vector>
-#include <iostream>
-#include <cstring> // for strcmp
-
-#include "IHwAccess.h"
-#include "MmioBus.h"
-#include "TraceControlRegisters.h" // for register offsets and bit definitions (deubg/logging purposes)
-
-namespace tci {
-
-// Adapter: makes MmioBus look like a probe (IHwAccess)
-class ProbeHwAccess final : public IHwAccess { // final to indicate this is not meant to be subclassed further
-public:
-    struct ComponentRegion
-    {
-        uint32_t baseAddress;
-        uint32_t size;
-        const char* name; // for debug/logging purposes (TraceEncoder, TraceFunnel, TraceRamSink)
-    };
-    
-    explicit ProbeHwAccess(MmioBus& bus, std::vector<ComponentRegion> regions) 
-        : bus_(bus), componentRegions_(regions) {}
-
-    void WriteMemory(std::uint32_t address, std::uint32_t value) override {
-        // std::cout << "[ProbeHwAccess::WriteMemory] Writing value 0x" << std::hex << value 
-        //             << " to address 0x" << address << std::dec << std::endl;
-
-        auto info = decode(address);
-        std::cout << "[PROBE WRITE]" << info.pretty << " <= 0x" << std::hex << value << std::dec << std::endl;
-        bus_.write32(address, value);
-    }
-
-    std::uint32_t ReadMemory(std::uint32_t address) override {
-        // std::cout << "[ProbeHwAccess::ReadMemory] Reading from address 0x" << std::hex << address 
-        //             << std::dec << std::endl;
-
-        auto info = decode(address);
-        uint32_t value = bus_.read32(address);
-        std::cout << "[PROBE READ]" << info.pretty << " => 0x" << std::hex << value << std::dec << std::endl;
-        return value;
-    }
-
-private:
-    struct DecodeInfo{
-        const char* componentName = "Unknown";
-        uint32_t base = 0;
-        uint32_t offset = 0;
-        const char* registerName = "Unknown";
-        std::string pretty;
-    };
-
-    DecodeInfo decode(uint32_t address) {
-        DecodeInfo info;
-        // Component Range
-        for(const auto& region : componentRegions_) {
-            if(address >= region.baseAddress && address < region.baseAddress + region.size) {
-                info.componentName = region.name;
-                info.base = region.baseAddress;
-                info.offset = address - region.baseAddress;
-                break;
-            }
-        }
-
-        // Register name based on offset (for known components)
-        info.registerName = regName(info.componentName, info.offset);
-
-        // Pretty string for logging
-        char buffer[256];
-        std::snprintf(buffer, sizeof(buffer), "%s + 0x%03X (%s)", 
-                      info.componentName, info.offset, info.registerName);
-        info.pretty = buffer;
-
-        return info;
-    }
-
-    static const char* regName(const char* componentName, uint32_t offset) {
-        // This is a simplified example. In a real implementation, you would have a more comprehensive mapping.
-        if (strcmp(componentName, "TraceEncoder") == 0) {
-            switch (offset) {
-                case tci::tr_te::TR_TE_CONTROL: return "TR_TE_CONTROL";
-                // Add more TraceEncoder registers as needed
-                default: return "Unknown Register";
-            }
-        } else if (strcmp(componentName, "TraceFunnel") == 0) {
-            switch (offset) {
-                case tci::tr_tf::TR_FUNNEL_CONTROL: return "TR_FUNNEL_CONTROL";
-                case tci::tr_tf::TR_FUNNEL_DIS_INPUT: return "TR_FUNNEL_DIS_INPUT";
-                // Add more TraceFunnel registers as needed
-                default: return "Unknown Register";
-            }
-        } else if (strcmp(componentName, "TraceRamSink") == 0) {
-            switch (offset) {
-                case tci::tr_ram::TR_RAM_CONTROL: return "TR_RAM_CONTROL";
-                case tci::tr_ram::TR_RAM_WP_LOW: return "TR_RAM_WP_LOW";
-                case tci::tr_ram::TR_RAM_RP_LOW: return "TR_RAM_RP_LOW";
-                case tci::tr_ram::TR_RAM_DATA: return "TR_RAM_DATA";
-                // Add more TraceRamSink registers as needed
-                default: return "Unknown Register";
-            }
-        }
-        return "Unknown Component";
-    }
-
-private:
-    MmioBus& bus_;
-    std::vector<ComponentRegion> componentRegions_;
-};
-
-} // namespace tci
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <iostream>
+#include <cstring> // for strcmp (region -> register map, once per region)
+#include <string>
+#include <utility>
+
+#include "IHwAccess.h"
+#include "MmioBus.h"
+#include "TransactionLog.h"
+#include "TraceControlRegisters.h" // register descriptor tables (debug/logging purposes)
+
+// Compile-time switch: -DTCI_PROBE_LOG=0 removes all probe logging code (LogMode is ignored)
+#ifndef TCI_PROBE_LOG
+#define TCI_PROBE_LOG 1
+#endif
+
+namespace tci {
+
+// Adapter: makes MmioBus look like a probe (IHwAccess)
+class ProbeHwAccess final : public IHwAccess { // final to indicate this is not meant to be subclassed further
+public:
+    struct ComponentRegion
+    {
+        uint32_t baseAddress;
+        uint32_t size;
+        const char* name; // for debug/logging purposes (TraceEncoder, TraceFunnel, TraceRamSink)
+        const reg::RegisterMap* registers = nullptr; // register names; looked up from name when not given
+    };
+    
+    // Text: decode and print every access (default, human readable, slow)
+    // Binary: append a fixed-size record to the TransactionLog ring, decode later with printTransactionLog()
+    // Off: no logging
+    enum class LogMode { Text, Binary, Off };
+
+    explicit ProbeHwAccess(MmioBus& bus, std::vector<ComponentRegion> regions, LogMode mode = LogMode::Text,
+                           std::size_t logCapacity = 1u << 16) 
+        : bus_(bus), componentRegions_(resolveRegisters(std::move(regions))), logMode_(mode),
+          log_(mode == LogMode::Binary ? logCapacity : 1) {}
+
+    void WriteMemory(std::uint32_t address, std::uint32_t value) override {
+        // std::cout << "[ProbeHwAccess::WriteMemory] Writing value 0x" << std::hex << value 
+        //             << " to address 0x" << address << std::dec << std::endl;
+
+#if TCI_PROBE_LOG
+        if (logMode_ == LogMode::Binary) {
+            log_.record(TransactionRecord::Write, address, value);
+        } else if (logMode_ == LogMode::Text) {
+            auto info = decode(address, componentRegions_);
+            std::cout << "[PROBE WRITE]" << info.pretty << " <= 0x" << std::hex << value << std::dec << '\n';
+        }
+#endif
+        bus_.write32(address, value);
+    }
+
+    std::uint32_t ReadMemory(std::uint32_t address) override {
+        // std::cout << "[ProbeHwAccess::ReadMemory] Reading from address 0x" << std::hex << address 
+        //             << std::dec << std::endl;
+
+        uint32_t value = bus_.read32(address);
+#if TCI_PROBE_LOG
+        if (logMode_ == LogMode::Binary) {
+            log_.record(TransactionRecord::Read, address, value);
+        } else if (logMode_ == LogMode::Text) {
+            auto info = decode(address, componentRegions_);
+            std::cout << "[PROBE READ]" << info.pretty << " => 0x" << std::hex << value << std::dec << '\n';
+        }
+#endif
+        return value;
+    }
+
+    void WriteMemoryBlock(std::uint32_t address, const std::uint32_t* src, std::size_t count, bool fixedAddress) override {
+#if TCI_PROBE_LOG
+        if (logMode_ == LogMode::Binary) {
+            log_.record(TransactionRecord::WriteBlock, address, count ? src[0] : 0u, blockCount(count, fixedAddress));
+        } else if (logMode_ == LogMode::Text) {
+            auto info = decode(address, componentRegions_);
+            std::cout << "[PROBE WRITE BLOCK]" << info.pretty << " <= " << count << " words"
+                      << (fixedAddress ? " (fixed address)" : "") << '\n';
+        }
+#endif
+        bus_.writeBlock32(address, src, count, fixedAddress);
+    }
+
+    void ReadMemoryBlock(std::uint32_t address, std::uint32_t* dst, std::size_t count, bool fixedAddress) override {
+        bus_.readBlock32(address, dst, count, fixedAddress);
+#if TCI_PROBE_LOG
+        if (logMode_ == LogMode::Binary) {
+            log_.record(TransactionRecord::ReadBlock, address, count ? dst[0] : 0u, blockCount(count, fixedAddress));
+        } else if (logMode_ == LogMode::Text) {
+            auto info = decode(address, componentRegions_);
+            std::cout << "[PROBE READ BLOCK]" << info.pretty << " => " << count << " words"
+                      << (fixedAddress ? " (fixed address)" : "") << '\n';
+        }
+#endif
+    }
+
+    // Switching to Binary allocates the ring if the probe was created in another mode
+    void setLogMode(LogMode mode, std::size_t logCapacity = 1u << 16) {
+        if (mode == LogMode::Binary && logMode_ != LogMode::Binary) log_ = TransactionLog(logCapacity);
+        logMode_ = mode;
+    }
+    LogMode logMode() const { return logMode_; }
+
+    const TransactionLog& transactionLog() const { return log_; }
+    TransactionLog& transactionLog() { return log_; }
+
+    // Offline pretty-printer: component/register decode happens here, not on the access path
+    void printTransactionLog(std::ostream& os) const {
+        std::vector<TransactionRecord> records;
+        records.reserve(log_.size());
+        for (std::size_t i = 0; i < log_.size(); ++i) records.push_back(log_.at(i));
+        printRecords(os, records, componentRegions_);
+    }
+
+    // Register map for a component name (TraceEncoder, TraceFunnel, TraceRamSink), nullptr if unknown
+    static const reg::RegisterMap* registerMap(const char* componentName) {
+        static const reg::RegisterMap* const maps[] = {&tci::tr_te::REGISTERS, &tci::tr_tf::REGISTERS, &tci::tr_ram::REGISTERS};
+        for (const reg::RegisterMap* map : maps) {
+            if (strcmp(componentName, map->component) == 0) return map;
+        }
+        return nullptr;
+    }
+
+    // Also usable on records reloaded with TransactionLog::load()
+    static void printRecords(std::ostream& os, const std::vector<TransactionRecord>& records,
+                             const std::vector<ComponentRegion>& regions) {
+        static const char* const tags[] = {"[PROBE READ]", "[PROBE WRITE]", "[PROBE READ BLOCK]", "[PROBE WRITE BLOCK]"};
+        const std::vector<ComponentRegion> resolved = resolveRegisters(regions);
+        for (const auto& r : records) {
+            const auto info = decode(r.address, resolved);
+            const std::uint32_t words = r.count & ~TransactionLog::FIXED_ADDRESS;
+            const char* dir = (r.kind == TransactionRecord::Read || r.kind == TransactionRecord::ReadBlock) ? " => " : " <= ";
+            os << "@" << r.timestampNs << "ns " << tags[r.kind & 0x3] << info.pretty << dir;
+            if (r.kind == TransactionRecord::Read || r.kind == TransactionRecord::Write) {
+                os << "0x" << std::hex << r.value << std::dec;
+            } else {
+                os << words << " words" << ((r.count & TransactionLog::FIXED_ADDRESS) ? " (fixed address)" : "");
+            }
+            os << '\n';
+        }
+    }
+
+private:
+    static std::uint32_t blockCount(std::size_t count, bool fixedAddress) {
+        return (static_cast<std::uint32_t>(count) & ~TransactionLog::FIXED_ADDRESS) | (fixedAddress ? TransactionLog::FIXED_ADDRESS : 0u);
+    }
+
+    struct DecodeInfo{
+        const char* componentName = "Unknown";
+        uint32_t base = 0;
+        uint32_t offset = 0;
+        const char* registerName = "Unknown";
+        std::string pretty;
+    };
+
+    static std::vector<ComponentRegion> resolveRegisters(std::vector<ComponentRegion> regions) {
+        for (auto& region : regions) {
+            if (!region.registers) region.registers = registerMap(region.name);
+        }
+        return regions;
+    }
+
+    // Regions carry their register map, so decoding is a range check plus one table index
+    static DecodeInfo decode(uint32_t address, const std::vector<ComponentRegion>& regions) {
+        DecodeInfo info;
+        const reg::RegisterMap* registers = nullptr;
+        // Component Range
+        for(const auto& region : regions) {
+            if(address >= region.baseAddress && address < region.baseAddress + region.size) {
+                info.componentName = region.name;
+                info.base = region.baseAddress;
+                info.offset = address - region.baseAddress;
+                registers = region.registers;
+                break;
+            }
+        }
+
+        // Register name based on offset (for known components)
+        info.registerName = registers ? registers->nameOf(info.offset) : "Unknown Component";
+
+        // Pretty string for logging
+        char buffer[256];
+        std::snprintf(buffer, sizeof(buffer), "%s + 0x%03X (%s)", 
+                      info.componentName, info.offset, info.registerName);
+        info.pretty = buffer;
+
+        return info;
+    }
+
+private:
+    MmioBus& bus_;
+    std::vector<ComponentRegion> componentRegions_;
+    LogMode logMode_;
+    TransactionLog log_;
+};
+
+} // namespace tci
@@ -0,0 +1,94 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <stdexcept>
+
+#if defined(_WIN32)
+#error "ProbeServer/RemoteHwAccess use POSIX sockets (Unix-domain or loopback TCP)"
+#endif
+
+#include <cerrno>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+
+namespace tci {
+    // Wire format between RemoteHwAccess (client) and ProbeServer, host byte order (both ends on one host).
+    // A client sends any number of requests back to back; the server executes them in order and answers
+    // every request with a response, in order. Everything the server has received is answered with one send.
+    //   request : op(u8) flags(u8) reserved(u16) address(u32) arg(u32)    arg = value (Write) or word count (blocks)
+    //             WriteBlock is followed by count words
+    //   response: op(u8) status(u8) reserved(u16) count(u32), followed by count words (Read: 1, ReadBlock: count)
+    namespace probe_wire {
+        enum Op : std::uint8_t { Read = 1, Write = 2, ReadBlock = 3, WriteBlock = 4 };
+        enum Status : std::uint8_t { Ok = 0, BusError = 1, BadRequest = 2 };
+        static constexpr std::uint8_t FLAG_FIXED_ADDRESS = 0x1u;
+
+        struct Request {
+            std::uint8_t op;
+            std::uint8_t flags;
+            std::uint16_t reserved;
+            std::uint32_t address;
+            std::uint32_t arg;
+        };
+        struct Response {
+            std::uint8_t op;
+            std::uint8_t status;
+            std::uint16_t reserved;
+            std::uint32_t count;
+        };
+        static_assert(sizeof(Request) == 12 && sizeof(Response) == 8, "probe wire records must be packed");
+
+        static constexpr std::uint32_t MAX_BLOCK_WORDS = 1u << 20;
+        static constexpr int SOCKET_BUFFER_BYTES = 1 << 18;
+
+        inline void setSocketOptions(int fd, bool tcp) {
+            int bufferBytes = SOCKET_BUFFER_BYTES;
+            ::setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &bufferBytes, sizeof(bufferBytes));
+            ::setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &bufferBytes, sizeof(bufferBytes));
+            if (tcp) {
+                int noDelay = 1; // requests are batched by the client; do not let Nagle hold them back
+                ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+            }
+        }
+
+        inline sockaddr_un unixAddress(const std::string& path) {
+            sockaddr_un addr{};
+            addr.sun_family = AF_UNIX;
+            if (path.size() >= sizeof(addr.sun_path)) throw std::invalid_argument("probe socket path too long: " + path);
+            std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+            return addr;
+        }
+
+        // Returns false when the peer closed the connection
+        inline bool sendAll(int fd, const void* data, std::size_t size) {
+            const auto* p = static_cast<const std::uint8_t*>(data);
+            while (size > 0) {
+                const ssize_t n = ::send(fd, p, size, MSG_NOSIGNAL);
+                if (n < 0 && errno == EINTR) continue;
+                if (n <= 0) return false;
+                p += n;
+                size -= static_cast<std::size_t>(n);
+            }
+            return true;
+        }
+
+        inline bool recvAll(int fd, void* data, std::size_t size) {
+            auto* p = static_cast<std::uint8_t*>(data);
+            while (size > 0) {
+                const ssize_t n = ::recv(fd, p, size, 0);
+                if (n < 0 && errno == EINTR) continue;
+                if (n <= 0) return false;
+                p += n;
+                size -= static_cast<std::size_t>(n);
+            }
+            return true;
+        }
+    }
+}
@@ -0,0 +1,193 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <stdexcept>
+
+#include <poll.h>
+
+#include "ProbeProtocol.h"
+#include "MmioBus.h"
+#include "TraceLog.h"
+
+namespace tci {
+    // Exposes an MmioBus (e.g. TraceSystem::mmioBus) over a Unix-domain or loopback TCP socket, so the
+    // controller can run against a real transport through RemoteHwAccess. One client is served at a time,
+    // on a background thread. Bus accesses happen on that thread.
+    class ProbeServer {
+    public:
+        explicit ProbeServer(MmioBus& bus) : bus_(bus) {}
+
+        ~ProbeServer() { stop(); }
+
+        ProbeServer(const ProbeServer&) = delete;
+        ProbeServer& operator=(const ProbeServer&) = delete;
+
+        // Listen on a Unix-domain socket at `path` (an existing socket file is replaced)
+        void listenUnix(const std::string& path) {
+            const sockaddr_un addr = probe_wire::unixAddress(path);
+            ::unlink(path.c_str());
+            openListener(AF_UNIX, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr));
+            unixPath_ = path;
+        }
+
+        // Listen on 127.0.0.1:port; port 0 picks a free port. Returns the bound port.
+        std::uint16_t listenTcp(std::uint16_t port = 0) {
+            sockaddr_in addr{};
+            addr.sin_family = AF_INET;
+            addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            addr.sin_port = htons(port);
+            openListener(AF_INET, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr));
+            socklen_t len = sizeof(addr);
+            ::getsockname(listenFd_, reinterpret_cast<sockaddr*>(&addr), &len);
+            return ntohs(addr.sin_port);
+        }
+
+        // Simulated probe round-trip: applied once per received batch, before its responses are sent
+        void setRoundTripDelay(std::chrono::microseconds delay) { delayUs_.store(delay.count(), std::memory_order_relaxed); }
+
+        void stop() {
+            running_.store(false, std::memory_order_release);
+            if (thread_.joinable()) thread_.join();
+            if (listenFd_ >= 0) ::close(listenFd_);
+            listenFd_ = -1;
+            if (!unixPath_.empty()) ::unlink(unixPath_.c_str());
+            unixPath_.clear();
+        }
+
+        // Statistics (exact once the client has disconnected)
+        std::uint64_t requestsServed() const { return requests_.load(std::memory_order_relaxed); }
+        std::uint64_t batchesServed() const { return batches_.load(std::memory_order_relaxed); }
+
+    private:
+        static constexpr int POLL_MS = 20; // how quickly the server thread notices stop()
+
+        void openListener(int family, const sockaddr* addr, socklen_t len) {
+            if (listenFd_ >= 0) throw std::logic_error("ProbeServer is already listening");
+            listenFd_ = ::socket(family, SOCK_STREAM, 0);
+            if (listenFd_ < 0) throw std::runtime_error("ProbeServer: cannot create socket");
+            tcp_ = (family == AF_INET);
+            int reuse = 1;
+            ::setsockopt(listenFd_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+            if (::bind(listenFd_, addr, len) != 0 || ::listen(listenFd_, 4) != 0) {
+                ::close(listenFd_);
+                listenFd_ = -1;
+                throw std::runtime_error("ProbeServer: cannot bind/listen");
+            }
+            running_.store(true, std::memory_order_release);
+            thread_ = std::thread([this] { acceptLoop(); });
+        }
+
+        // Wait for fd to become readable; false when stop() was called
+        bool waitReadable(int fd) {
+            pollfd p{fd, POLLIN, 0};
+            while (running_.load(std::memory_order_acquire)) {
+                const int r = ::poll(&p, 1, POLL_MS);
+                if (r > 0) return true;
+                if (r < 0 && errno != EINTR) return false;
+            }
+            return false;
+        }
+
+        void acceptLoop() {
+            while (waitReadable(listenFd_)) {
+                const int fd = ::accept(listenFd_, nullptr, nullptr);
+                if (fd < 0) continue;
+                probe_wire::setSocketOptions(fd, tcp_);
+                serve(fd);
+                ::close(fd);
+            }
+        }
+
+        void serve(int fd) {
+            std::vector<std::uint8_t> in;
+            std::vector<std::uint8_t> out;
+            std::uint8_t chunk[1 << 16];
+            while (waitReadable(fd)) {
+                const ssize_t n = ::recv(fd, chunk, sizeof(chunk), 0);
+                if (n < 0 && errno == EINTR) continue;
+                if (n <= 0) return; // client closed
+                in.insert(in.end(), chunk, chunk + n);
+
+                // Execute every complete request received so far
+                std::size_t pos = 0;
+                out.clear();
+                while (in.size() - pos >= sizeof(probe_wire::Request)) {
+                    probe_wire::Request req;
+                    std::memcpy(&req, in.data() + pos, sizeof(req));
+                    std::size_t need = sizeof(req);
+                    if (req.op == probe_wire::WriteBlock) {
+                        if (req.arg > probe_wire::MAX_BLOCK_WORDS) return; // malformed stream: drop the client
+                        need += 4 * static_cast<std::size_t>(req.arg);
+                    }
+                    if (in.size() - pos < need) break;
+                    execute(req, in.data() + pos + sizeof(req), out);
+                    pos += need;
+                    requests_.fetch_add(1, std::memory_order_relaxed);
+                }
+                in.erase(in.begin(), in.begin() + static_cast<std::ptrdiff_t>(pos));
+                if (out.empty()) continue;
+
+                const long long delay = delayUs_.load(std::memory_order_relaxed);
+                if (delay > 0) std::this_thread::sleep_for(std::chrono::microseconds(delay));
+                batches_.fetch_add(1, std::memory_order_relaxed);
+                if (!probe_wire::sendAll(fd, out.data(), out.size())) return;
+            }
+        }
+
+        void execute(const probe_wire::Request& req, const std::uint8_t* payload, std::vector<std::uint8_t>& out) {
+            probe_wire::Response resp{req.op, probe_wire::Ok, 0, 0};
+            const bool fixed = (req.flags & probe_wire::FLAG_FIXED_ADDRESS) != 0;
+            words_.clear();
+            try {
+                switch (req.op) {
+                    case probe_wire::Read:
+                        words_.push_back(bus_.read32(req.address));
+                        break;
+                    case probe_wire::Write:
+                        bus_.write32(req.address, req.arg);
+                        break;
+                    case probe_wire::ReadBlock:
+                        if (req.arg > probe_wire::MAX_BLOCK_WORDS) { resp.status = probe_wire::BadRequest; break; }
+                        words_.resize(req.arg);
+                        bus_.readBlock32(req.address, words_.data(), words_.size(), fixed);
+                        break;
+                    case probe_wire::WriteBlock:
+                        words_.resize(req.arg);
+                        std::memcpy(words_.data(), payload, 4 * words_.size());
+                        bus_.writeBlock32(req.address, words_.data(), words_.size(), fixed);
+                        words_.clear();
+                        break;
+                    default:
+                        resp.status = probe_wire::BadRequest;
+                }
+            } catch (const std::exception& e) {
+                TCI_LOG_WARN("[ProbeServer::execute] " << e.what());
+                resp.status = probe_wire::BusError;
+                words_.clear();
+            }
+            if (resp.status != probe_wire::Ok) words_.clear();
+            resp.count = static_cast<std::uint32_t>(words_.size());
+            const std::size_t at = out.size();
+            out.resize(at + sizeof(resp) + 4 * words_.size());
+            std::memcpy(out.data() + at, &resp, sizeof(resp));
+            if (!words_.empty()) std::memcpy(out.data() + at + sizeof(resp), words_.data(), 4 * words_.size());
+        }
+
+        MmioBus& bus_;
+        int listenFd_ = -1;
+        bool tcp_ = false;
+        std::string unixPath_;
+        std::thread thread_;
+        std::atomic<bool> running_{false};
+        std::atomic<long long> delayUs_{0};
+        std::atomic<std::uint64_t> requests_{0};
+        std::atomic<std::uint64_t> batches_{0};
+        std::vector<std::uint32_t> words_; // scratch for one request's data
+    };
+}
@@ -0,0 +1,153 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+// x86-64 only: SSE2 is part of the baseline there
+#if defined(__x86_64__) || defined(_M_X64)
+#define TCI_SIMD_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+#else
+#define TCI_SIMD_X86 0
+#endif
+
+// GCC/Clang compile AVX2 functions for the target CPU without -mavx2 on the whole build
+#if TCI_SIMD_X86 && (defined(__GNUC__) || defined(__clang__))
+#define TCI_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define TCI_TARGET_AVX2
+#endif
+
+namespace tci {
+    // Raw-format record kernels: the raw format is an interleave of pc and opcode words
+    // (little-endian bytes), decoding fetched words is the matching deinterleave.
+    //   packRaw:   pcs[n], opcodes[n] -> dst[8 * n] bytes (pc0, op0, pc1, op1, ...)
+    //   unpackRaw: words[2 * n] (as fetched from TR_RAM_DATA) -> pcs[n], opcodes[n]
+    // Scalar is the byte-wise reference; SSE2/AVX2 are selected at runtime on x86.
+    namespace simd {
+        enum class Level { Scalar, SSE2, AVX2 };
+
+        inline void packRawScalar(const std::uint32_t* pcs, const std::uint32_t* opcodes, std::size_t n, std::uint8_t* dst) {
+            for (std::size_t i = 0; i < n; ++i) {
+                for (int b = 0; b < 4; ++b) {
+                    dst[8 * i + b]     = static_cast<std::uint8_t>(pcs[i] >> (8 * b));
+                    dst[8 * i + 4 + b] = static_cast<std::uint8_t>(opcodes[i] >> (8 * b));
+                }
+            }
+        }
+
+        inline void unpackRawScalar(const std::uint32_t* words, std::size_t n, std::uint32_t* pcs, std::uint32_t* opcodes) {
+            for (std::size_t i = 0; i < n; ++i) {
+                pcs[i] = words[2 * i];
+                opcodes[i] = words[2 * i + 1];
+            }
+        }
+
+#if TCI_SIMD_X86
+        // x86 is little-endian: interleaving the 32-bit words yields the raw byte layout directly
+        inline void packRawSse2(const std::uint32_t* pcs, const std::uint32_t* opcodes, std::size_t n, std::uint8_t* dst) {
+            std::size_t i = 0;
+            for (; i + 4 <= n; i += 4) {
+                const __m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pcs + i));
+                const __m128i o = _mm_loadu_si128(reinterpret_cast<const __m128i*>(opcodes + i));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 8 * i), _mm_unpacklo_epi32(p, o));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 8 * i + 16), _mm_unpackhi_epi32(p, o));
+            }
+            packRawScalar(pcs + i, opcodes + i, n - i, dst + 8 * i);
+        }
+
+        inline void unpackRawSse2(const std::uint32_t* words, std::size_t n, std::uint32_t* pcs, std::uint32_t* opcodes) {
+            std::size_t i = 0;
+            for (; i + 4 <= n; i += 4) {
+                // [p0 o0 p1 o1] [p2 o2 p3 o3] -> [p0 p1 o0 o1] [p2 p3 o2 o3]
+                const __m128i w0 = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(words + 2 * i)), 0xD8);
+                const __m128i w1 = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(words + 2 * i + 4)), 0xD8);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(pcs + i), _mm_unpacklo_epi64(w0, w1));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(opcodes + i), _mm_unpackhi_epi64(w0, w1));
+            }
+            unpackRawScalar(words + 2 * i, n - i, pcs + i, opcodes + i);
+        }
+
+        TCI_TARGET_AVX2 inline void packRawAvx2(const std::uint32_t* pcs, const std::uint32_t* opcodes, std::size_t n, std::uint8_t* dst) {
+            std::size_t i = 0;
+            for (; i + 8 <= n; i += 8) {
+                const __m256i p = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pcs + i));
+                const __m256i o = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(opcodes + i));
+                const __m256i lo = _mm256_unpacklo_epi32(p, o); // [r0 r1 | r4 r5]
+                const __m256i hi = _mm256_unpackhi_epi32(p, o); // [r2 r3 | r6 r7]
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + 8 * i), _mm256_permute2x128_si256(lo, hi, 0x20));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + 8 * i + 32), _mm256_permute2x128_si256(lo, hi, 0x31));
+            }
+            packRawSse2(pcs + i, opcodes + i, n - i, dst + 8 * i);
+        }
+
+        TCI_TARGET_AVX2 inline void unpackRawAvx2(const std::uint32_t* words, std::size_t n, std::uint32_t* pcs, std::uint32_t* opcodes) {
+            const __m256i split = _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7);
+            std::size_t i = 0;
+            for (; i + 8 <= n; i += 8) {
+                // [r0..r3] -> [p0 p1 p2 p3 | o0 o1 o2 o3], [r4..r7] likewise
+                const __m256i w0 = _mm256_permutevar8x32_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(words + 2 * i)), split);
+                const __m256i w1 = _mm256_permutevar8x32_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(words + 2 * i + 8)), split);
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(pcs + i), _mm256_permute2x128_si256(w0, w1, 0x20));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(opcodes + i), _mm256_permute2x128_si256(w0, w1, 0x31));
+            }
+            unpackRawSse2(words + 2 * i, n - i, pcs + i, opcodes + i);
+        }
+#endif
+
+        // Best level supported by this CPU (detected once)
+        inline Level detectLevel() {
+#if TCI_SIMD_X86
+#if defined(_MSC_VER) && !defined(__clang__)
+            int info[4];
+            __cpuid(info, 0);
+            if (info[0] >= 7) {
+                __cpuidex(info, 7, 0);
+                const bool avx2 = (info[1] & (1 << 5)) != 0;
+                __cpuid(info, 1);
+                const bool osxsave = (info[2] & (1 << 27)) != 0;
+                if (avx2 && osxsave && (_xgetbv(0) & 0x6) == 0x6) return Level::AVX2;
+            }
+            return Level::SSE2;
+#else
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx2") ? Level::AVX2 : Level::SSE2;
+#endif
+#else
+            return Level::Scalar;
+#endif
+        }
+
+        inline Level bestLevel() {
+            static const Level level = detectLevel();
+            return level;
+        }
+
+        // Levels above what the CPU supports fall back to the best supported one
+        inline void packRaw(const std::uint32_t* pcs, const std::uint32_t* opcodes, std::size_t n, std::uint8_t* dst,
+                            Level level = bestLevel()) {
+#if TCI_SIMD_X86
+            if (level > bestLevel()) level = bestLevel();
+            if (level == Level::AVX2) return packRawAvx2(pcs, opcodes, n, dst);
+            if (level == Level::SSE2) return packRawSse2(pcs, opcodes, n, dst);
+#else
+            (void)level;
+#endif
+            packRawScalar(pcs, opcodes, n, dst);
+        }
+
+        inline void unpackRaw(const std::uint32_t* words, std::size_t n, std::uint32_t* pcs, std::uint32_t* opcodes,
+                              Level level = bestLevel()) {
+#if TCI_SIMD_X86
+            if (level > bestLevel()) level = bestLevel();
+            if (level == Level::AVX2) return unpackRawAvx2(words, n, pcs, opcodes);
+            if (level == Level::SSE2) return unpackRawSse2(words, n, pcs, opcodes);
+#else
+            (void)level;
+#endif
+            unpackRawScalar(words, n, pcs, opcodes);
+        }
+    }
+}
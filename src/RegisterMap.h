@@ -0,0 +1,105 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <stdexcept>
+
+namespace tci {
+namespace reg {
+
+    // Multi-bit field: value bits [shift + width - 1 : shift], WARL-legal values 0..maxValue
+    struct Field {
+        std::uint32_t shift;
+        std::uint32_t width;
+        std::uint32_t maxValue;
+
+        constexpr std::uint32_t valueMask() const { return width >= 32 ? ~0u : ((1u << width) - 1u); }
+        constexpr std::uint32_t mask() const { return valueMask() << shift; }
+        constexpr std::uint32_t get(std::uint32_t reg) const { return (reg & mask()) >> shift; }
+        // v placed in the field, other bits 0
+        constexpr std::uint32_t place(std::uint32_t v) const { return (v << shift) & mask(); }
+        constexpr std::uint32_t set(std::uint32_t reg, std::uint32_t v) const { return (reg & ~mask()) | place(v); }
+        // WARL: out-of-range values read back as maxValue
+        constexpr std::uint32_t clamp(std::uint32_t reg) const { return get(reg) > maxValue ? set(reg, maxValue) : reg; }
+    };
+
+    // One register: offset within the component, name, write behaviour and its multi-bit fields
+    struct Register {
+        static constexpr std::size_t MAX_FIELDS = 4;
+
+        constexpr Register(std::uint32_t offset_, const char* name_, std::uint32_t rwMask_,
+                           std::uint32_t roMask_ = 0, std::uint32_t rw1cMask_ = 0)
+            : offset(offset_), name(name_), rwMask(rwMask_), roMask(roMask_), rw1cMask(rw1cMask_), fields{}, fieldCount(0) {}
+
+        template <std::size_t N>
+        constexpr Register(std::uint32_t offset_, const char* name_, std::uint32_t rwMask_,
+                           std::uint32_t roMask_, std::uint32_t rw1cMask_, const Field (&fields_)[N])
+            : Register(offset_, name_, rwMask_, roMask_, rw1cMask_) {
+            static_assert(N <= MAX_FIELDS, "reg::Register: raise MAX_FIELDS");
+            for (std::size_t i = 0; i < N; ++i) {
+                if ((fields_[i].mask() & ~rwMask_) != 0) throw std::logic_error("reg::Register: field outside the RW bits");
+                fields[i] = fields_[i];
+            }
+            fieldCount = N;
+        }
+
+        // Bits software sets by writing them (RW1C bits are status, written only to clear)
+        constexpr std::uint32_t writableMask() const { return rwMask & ~rw1cMask; }
+
+        constexpr std::uint32_t normalizeWarl(std::uint32_t value) const {
+            for (std::size_t i = 0; i < fieldCount; ++i) value = fields[i].clamp(value);
+            return value;
+        }
+
+        // Register value after software writes value over old: RO and RW1C bits are kept, writable
+        // bits are taken from value (WARL-normalized), RW1C bits written as 1 clear
+        constexpr std::uint32_t applyWrite(std::uint32_t old, std::uint32_t value) const {
+            const std::uint32_t kept = old & (roMask | rw1cMask);
+            return (kept | normalizeWarl(value & writableMask())) & ~(value & rw1cMask);
+        }
+
+        std::uint32_t offset;
+        const char* name;
+        std::uint32_t rwMask;
+        std::uint32_t roMask;
+        std::uint32_t rw1cMask;
+        Field fields[MAX_FIELDS];
+        std::size_t fieldCount;
+    };
+
+    // A component's registers with an offset -> register slot table built at compile time, so
+    // lookups (probe decode, names) are one array index instead of a search or string compare
+    struct RegisterMap {
+        static constexpr std::size_t SLOTS = 32; // word offsets 0x000..0x07C
+
+        template <std::size_t N>
+        constexpr RegisterMap(const char* component_, const Register* const (&registers_)[N])
+            : component(component_), registers(registers_), count(N), slots{} {
+            static_assert(N < 128, "reg::RegisterMap: slot index is 8 bits");
+            for (std::size_t s = 0; s < SLOTS; ++s) slots[s] = -1;
+            for (std::size_t i = 0; i < N; ++i) {
+                const std::uint32_t offset = registers_[i]->offset;
+                if ((offset & 0x3u) != 0 || offset / 4 >= SLOTS) throw std::logic_error("reg::RegisterMap: offset out of range");
+                if (slots[offset / 4] != -1) throw std::logic_error("reg::RegisterMap: duplicate offset");
+                slots[offset / 4] = static_cast<std::int8_t>(i);
+            }
+        }
+
+        constexpr const Register* find(std::uint32_t offset) const {
+            if ((offset & 0x3u) != 0 || offset / 4 >= SLOTS) return nullptr;
+            const int slot = slots[offset / 4];
+            return slot < 0 ? nullptr : registers[slot];
+        }
+
+        constexpr const char* nameOf(std::uint32_t offset) const {
+            const Register* r = find(offset);
+            return r ? r->name : "Unknown Register";
+        }
+
+        const char* component;
+        const Register* const* registers;
+        std::size_t count;
+        std::int8_t slots[SLOTS];
+    };
+
+} // namespace reg
+} // namespace tci
@@ -0,0 +1,262 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include <cassert>
+
+#include <poll.h>
+
+#include "IHwAccess.h"
+#include "ProbeProtocol.h"
+
+namespace tci {
+    // IHwAccess client for ProbeServer. Accesses are queued locally and sent in batches: many requests
+    // are outstanding per round-trip, and the server answers a batch with one send.
+    //  - ReadMemory/ReadMemoryBlock send everything queued and wait for the answers (one round-trip).
+    //  - WriteMemory/WriteMemoryBlock wait for their acknowledgement as well, unless posted writes are
+    //    enabled: then they only queue and travel with the next read or flush().
+    //  - queueRead/queueWrite + flush() pipeline arbitrary sequences explicitly; the IHwAccess
+    //    QueueRead/QueueWrite/Flush interface (used by TraceControllerInterface) maps onto the same queue.
+    class RemoteHwAccess : public IHwAccess {
+    public:
+        using Handle = std::size_t;
+
+        // Connect to a Unix-domain socket
+        explicit RemoteHwAccess(const std::string& unixPath) {
+            const sockaddr_un addr = probe_wire::unixAddress(unixPath);
+            connectTo(AF_UNIX, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr));
+        }
+
+        // Connect to a TCP port (e.g. ProbeServer::listenTcp) on host (dotted IPv4)
+        RemoteHwAccess(const std::string& host, std::uint16_t port) {
+            sockaddr_in addr{};
+            addr.sin_family = AF_INET;
+            addr.sin_port = htons(port);
+            if (::inet_pton(AF_INET, host.c_str(), &addr.sin_addr) != 1) throw std::invalid_argument("RemoteHwAccess: bad host " + host);
+            connectTo(AF_INET, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr));
+        }
+
+        ~RemoteHwAccess() override {
+            if (fd_ >= 0) ::close(fd_);
+        }
+
+        RemoteHwAccess(const RemoteHwAccess&) = delete;
+        RemoteHwAccess& operator=(const RemoteHwAccess&) = delete;
+
+        // Posted writes: WriteMemory returns without waiting; bus errors surface at the next flush
+        void setPostedWrites(bool posted) { postedWrites_ = posted; }
+
+        void WriteMemory(std::uint32_t address, std::uint32_t value) override {
+            queueWrite(address, value);
+            if (!postedWrites_) flush();
+        }
+
+        std::uint32_t ReadMemory(std::uint32_t address) override {
+            const Handle h = queueRead(address);
+            flush();
+            return result(h);
+        }
+
+        void ReadMemoryBlock(std::uint32_t address, std::uint32_t* dst, std::size_t count, bool fixedAddress) override {
+            queueReadBlock(address, dst, count, fixedAddress);
+            flush();
+        }
+
+        void WriteMemoryBlock(std::uint32_t address, const std::uint32_t* src, std::size_t count, bool fixedAddress) override {
+            queueWriteBlock(address, src, count, fixedAddress);
+            if (!postedWrites_) flush();
+        }
+
+        // Explicit pipelining. A handle's value is available after flush() and stays valid until
+        // the next access is queued after that flush.
+        Handle queueRead(std::uint32_t address) {
+            startBatch();
+            results_.push_back(0);
+            enqueue(probe_wire::Read, 0, address, 0, nullptr, 0, results_.size() - 1);
+            return results_.size() - 1;
+        }
+
+        void queueWrite(std::uint32_t address, std::uint32_t value) {
+            startBatch();
+            enqueue(probe_wire::Write, 0, address, value, nullptr, 0, NO_RESULT);
+        }
+
+        // dst must stay valid until flush() returns
+        void queueReadBlock(std::uint32_t address, std::uint32_t* dst, std::size_t count, bool fixedAddress) {
+            if (count == 0) return;
+            checkBlock(count);
+            startBatch();
+            enqueue(probe_wire::ReadBlock, fixedAddress ? probe_wire::FLAG_FIXED_ADDRESS : 0, address,
+                    static_cast<std::uint32_t>(count), dst, count, NO_RESULT);
+        }
+
+        void queueWriteBlock(std::uint32_t address, const std::uint32_t* src, std::size_t count, bool fixedAddress) {
+            if (count == 0) return;
+            checkBlock(count);
+            startBatch();
+            enqueue(probe_wire::WriteBlock, fixedAddress ? probe_wire::FLAG_FIXED_ADDRESS : 0, address,
+                    static_cast<std::uint32_t>(count), nullptr, 0, NO_RESULT);
+            const std::size_t at = sendBuf_.size();
+            sendBuf_.resize(at + 4 * count);
+            std::memcpy(sendBuf_.data() + at, src, 4 * count);
+        }
+
+        std::uint32_t result(Handle h) const { return results_.at(h); }
+
+        // IHwAccess deferred interface
+        void QueueWrite(std::uint32_t address, std::uint32_t value) override { queueWrite(address, value); }
+
+        void QueueRead(std::uint32_t address, std::uint32_t* dst) override {
+            startBatch();
+            enqueue(probe_wire::Read, 0, address, 0, dst, 1, NO_RESULT);
+        }
+
+        void QueueReadBlock(std::uint32_t address, std::uint32_t* dst, std::size_t count, bool fixedAddress) override {
+            queueReadBlock(address, dst, count, fixedAddress);
+        }
+
+        void QueueWriteBlock(std::uint32_t address, const std::uint32_t* src, std::size_t count, bool fixedAddress) override {
+            queueWriteBlock(address, src, count, fixedAddress);
+        }
+
+        void Flush() override { flush(); }
+
+        // Split-phase flush: a batch that fits one window is sent by BeginFlush() and its responses are
+        // collected by EndFlush(), so one thread can have several connections in flight. Larger batches
+        // go out in EndFlush().
+        void BeginFlush() override {
+            if (inFlight_ || pending_.empty()) return;
+            std::size_t reqBytes = 0;
+            std::size_t respBytes = 0;
+            for (const Pending& p : pending_) {
+                reqBytes += p.requestBytes;
+                respBytes += sizeof(probe_wire::Response) + 4 * p.responseWords;
+            }
+            if (reqBytes > WINDOW_BYTES || respBytes > WINDOW_BYTES) return;
+            if (!probe_wire::sendAll(fd_, sendBuf_.data(), reqBytes)) throw std::runtime_error("RemoteHwAccess: connection lost");
+            ++roundTrips_;
+            inFlight_ = true;
+        }
+
+        bool FlushReady() override {
+            if (!inFlight_) return true;
+            pollfd p{fd_, POLLIN, 0};
+            return ::poll(&p, 1, 0) > 0; // first response bytes arrived: the server answers a batch with one send
+        }
+
+        void EndFlush() override { flush(); }
+
+        // Send all queued requests and wait for every response. Requests go out in windows of at most
+        // WINDOW_BYTES of requests and expected responses, so neither side can block on a full socket.
+        // Throws std::runtime_error if the server reported an error for any request (after draining all).
+        void flush() {
+            std::size_t sent = 0;
+            bool failed = false;
+            if (inFlight_) { // sent by BeginFlush()
+                inFlight_ = false;
+                for (; sent < pending_.size(); ++sent) failed = !receive(pending_[sent]) || failed;
+            }
+            while (sent < pending_.size()) {
+                std::size_t end = sent;
+                std::size_t reqBytes = 0;
+                std::size_t respBytes = 0;
+                do {
+                    reqBytes += pending_[end].requestBytes;
+                    respBytes += sizeof(probe_wire::Response) + 4 * pending_[end].responseWords;
+                    ++end;
+                } while (end < pending_.size() && reqBytes + pending_[end].requestBytes <= WINDOW_BYTES &&
+                         respBytes + sizeof(probe_wire::Response) + 4 * pending_[end].responseWords <= WINDOW_BYTES);
+
+                if (!probe_wire::sendAll(fd_, sendBuf_.data() + pending_[sent].offset, reqBytes)) {
+                    throw std::runtime_error("RemoteHwAccess: connection lost");
+                }
+                ++roundTrips_;
+                for (; sent < end; ++sent) failed = !receive(pending_[sent]) || failed;
+            }
+            requests_ += pending_.size();
+            pending_.clear();
+            sendBuf_.clear();
+            batchOpen_ = false;
+            if (failed) throw std::runtime_error("RemoteHwAccess: probe access failed on the target");
+        }
+
+        // Statistics: request/response round-trips (windows sent and awaited) and requests issued
+        std::uint64_t roundTrips() const { return roundTrips_; }
+        std::uint64_t requestsIssued() const { return requests_; }
+
+    private:
+        static constexpr std::size_t WINDOW_BYTES = 1u << 16;
+        static constexpr std::size_t NO_RESULT = static_cast<std::size_t>(-1);
+
+        struct Pending {
+            std::size_t offset;        // request start in sendBuf_
+            std::size_t requestBytes;
+            std::size_t responseWords; // expected payload words
+            std::uint32_t* dst;        // ReadBlock/QueueRead destination
+            std::size_t result;        // Read: index into results_
+        };
+
+        void connectTo(int family, const sockaddr* addr, socklen_t len) {
+            fd_ = ::socket(family, SOCK_STREAM, 0);
+            if (fd_ < 0) throw std::runtime_error("RemoteHwAccess: cannot create socket");
+            probe_wire::setSocketOptions(fd_, family == AF_INET);
+            if (::connect(fd_, addr, len) != 0) {
+                ::close(fd_);
+                fd_ = -1;
+                throw std::runtime_error("RemoteHwAccess: cannot connect to probe server");
+            }
+        }
+
+        static void checkBlock(std::size_t count) {
+            if (count > probe_wire::MAX_BLOCK_WORDS) throw std::invalid_argument("RemoteHwAccess: block too large");
+        }
+
+        // First access after a flush starts a new batch and retires the previous handles
+        void startBatch() {
+            if (!batchOpen_) {
+                results_.clear();
+                batchOpen_ = true;
+            }
+        }
+
+        void enqueue(std::uint8_t op, std::uint8_t flags, std::uint32_t address, std::uint32_t arg,
+                     std::uint32_t* dst, std::size_t readWords, std::size_t result) {
+            assert(!inFlight_); // EndFlush() first
+            const probe_wire::Request req{op, flags, 0, address, arg};
+            const std::size_t at = sendBuf_.size();
+            sendBuf_.resize(at + sizeof(req));
+            std::memcpy(sendBuf_.data() + at, &req, sizeof(req));
+            const std::size_t payload = (op == probe_wire::WriteBlock) ? 4 * static_cast<std::size_t>(arg) : 0;
+            const std::size_t words = (op == probe_wire::Read) ? 1 : readWords;
+            pending_.push_back({at, sizeof(req) + payload, words, dst, result});
+        }
+
+        // Returns false if the server reported an error for this request
+        bool receive(const Pending& p) {
+            probe_wire::Response resp;
+            if (!probe_wire::recvAll(fd_, &resp, sizeof(resp))) throw std::runtime_error("RemoteHwAccess: connection lost");
+            scratch_.resize(resp.count);
+            if (resp.count != 0 && !probe_wire::recvAll(fd_, scratch_.data(), 4 * scratch_.size())) {
+                throw std::runtime_error("RemoteHwAccess: connection lost");
+            }
+            if (resp.status != probe_wire::Ok) return false;
+            if (p.result != NO_RESULT && resp.count == 1) results_[p.result] = scratch_[0];
+            if (p.dst && resp.count == p.responseWords) std::memcpy(p.dst, scratch_.data(), 4 * scratch_.size());
+            return true;
+        }
+
+        int fd_ = -1;
+        bool postedWrites_ = false;
+        bool batchOpen_ = false;
+        bool inFlight_ = false; // batch sent by BeginFlush(), responses pending
+        std::vector<std::uint8_t> sendBuf_;  // queued requests, back to back
+        std::vector<Pending> pending_;
+        std::vector<std::uint32_t> results_; // queueRead values
+        std::vector<std::uint32_t> scratch_;
+        std::uint64_t roundTrips_ = 0;
+        std::uint64_t requests_ = 0;
+    };
+}
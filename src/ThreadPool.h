@@ -0,0 +1,209 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <type_traits>
+#include <atomic>
+#include <exception>
+
+namespace tci {
+    // Fixed-size worker pool with a shared FIFO queue. submit() returns a future for the result;
+    // exceptions thrown by a task are rethrown by future::get().
+    class ThreadPool {
+    public:
+        explicit ThreadPool(std::size_t threads = 0) {
+            if (threads == 0) threads = std::thread::hardware_concurrency();
+            if (threads == 0) threads = 1;
+            workers_.reserve(threads);
+            for (std::size_t i = 0; i < threads; ++i) {
+                workers_.emplace_back([this] { workerLoop(); });
+            }
+        }
+
+        ~ThreadPool() {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                stopping_ = true;
+            }
+            cv_.notify_all();
+            for (auto& worker : workers_) worker.join();
+        }
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        template <typename F>
+        auto submit(F&& task) -> std::future<std::invoke_result_t<F>> {
+            using Result = std::invoke_result_t<F>;
+            auto packaged = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(task));
+            std::future<Result> result = packaged->get_future();
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                queue_.emplace_back([packaged] { (*packaged)(); });
+            }
+            cv_.notify_one();
+            return result;
+        }
+
+        std::size_t size() const { return workers_.size(); }
+
+    private:
+        void workerLoop() {
+            for (;;) {
+                std::function<void()> task;
+                {
+                    std::unique_lock<std::mutex> lock(mutex_);
+                    cv_.wait(lock, [&] { return stopping_ || !queue_.empty(); });
+                    if (queue_.empty()) return; // stopping, queue drained
+                    task = std::move(queue_.front());
+                    queue_.pop_front();
+                }
+                task();
+            }
+        }
+
+        std::vector<std::thread> workers_;
+        std::mutex mutex_;
+        std::condition_variable cv_;
+        std::deque<std::function<void()>> queue_;
+        bool stopping_ = false;
+    };
+
+    // Work-stealing pool for task graphs whose tasks spawn follow-up tasks (e.g. one chunk of a
+    // system's workload submitting the next). Each worker owns a deque: submit() from a worker pushes
+    // to its own back and the worker pops from the back (the follow-up runs hot in its cache);
+    // submit() from outside round-robins over the workers. An idle worker steals from the front of
+    // another worker's deque. wait() blocks until every task, including spawned ones, has finished
+    // and rethrows the first exception a task threw.
+    class WorkStealingPool {
+    public:
+        explicit WorkStealingPool(std::size_t threads = 0) : queues_(workerCount(threads)) {
+            workers_.reserve(queues_.size());
+            for (std::size_t i = 0; i < queues_.size(); ++i) {
+                workers_.emplace_back([this, i] { workerLoop(i); });
+            }
+        }
+
+        ~WorkStealingPool() {
+            {
+                std::lock_guard<std::mutex> lock(sleepMutex_);
+                stopping_ = true;
+            }
+            sleepCv_.notify_all();
+            for (auto& worker : workers_) worker.join();
+        }
+
+        WorkStealingPool(const WorkStealingPool&) = delete;
+        WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+        void submit(std::function<void()> task) {
+            std::size_t target;
+            if (currentPool_ == this) target = currentWorker_;
+            else target = nextQueue_.fetch_add(1, std::memory_order_relaxed) % queues_.size();
+            unfinished_.fetch_add(1, std::memory_order_relaxed);
+            {
+                std::lock_guard<std::mutex> lock(queues_[target].mutex);
+                queues_[target].tasks.push_back(std::move(task));
+            }
+            queued_.fetch_add(1, std::memory_order_release);
+            {
+                std::lock_guard<std::mutex> lock(sleepMutex_); // no lost wake-up between a worker's check and wait
+            }
+            sleepCv_.notify_one();
+        }
+
+        void wait() {
+            std::unique_lock<std::mutex> lock(sleepMutex_);
+            doneCv_.wait(lock, [&] { return unfinished_.load(std::memory_order_acquire) == 0; });
+            if (error_) {
+                std::exception_ptr error = error_;
+                error_ = nullptr;
+                std::rethrow_exception(error);
+            }
+        }
+
+        std::size_t size() const { return workers_.size(); }
+
+        // Tasks taken from another worker's deque
+        std::uint64_t steals() const { return steals_.load(std::memory_order_relaxed); }
+
+    private:
+        struct WorkerQueue {
+            std::mutex mutex;
+            std::deque<std::function<void()>> tasks;
+        };
+
+        static std::size_t workerCount(std::size_t threads) {
+            if (threads == 0) threads = std::thread::hardware_concurrency();
+            return threads == 0 ? 1 : threads;
+        }
+
+        bool popLocal(std::size_t self, std::function<void()>& task) {
+            std::lock_guard<std::mutex> lock(queues_[self].mutex);
+            if (queues_[self].tasks.empty()) return false;
+            task = std::move(queues_[self].tasks.back());
+            queues_[self].tasks.pop_back();
+            return true;
+        }
+
+        bool steal(std::size_t self, std::function<void()>& task) {
+            for (std::size_t k = 1; k < queues_.size(); ++k) {
+                WorkerQueue& victim = queues_[(self + k) % queues_.size()];
+                std::lock_guard<std::mutex> lock(victim.mutex);
+                if (victim.tasks.empty()) continue;
+                task = std::move(victim.tasks.front());
+                victim.tasks.pop_front();
+                steals_.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+            return false;
+        }
+
+        void workerLoop(std::size_t self) {
+            currentPool_ = this;
+            currentWorker_ = self;
+            for (;;) {
+                std::function<void()> task;
+                if (popLocal(self, task) || steal(self, task)) {
+                    queued_.fetch_sub(1, std::memory_order_relaxed);
+                    try {
+                        task();
+                    } catch (...) {
+                        std::lock_guard<std::mutex> lock(sleepMutex_);
+                        if (!error_) error_ = std::current_exception();
+                    }
+                    if (unfinished_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                        std::lock_guard<std::mutex> lock(sleepMutex_);
+                        doneCv_.notify_all();
+                    }
+                    continue;
+                }
+                std::unique_lock<std::mutex> lock(sleepMutex_);
+                sleepCv_.wait(lock, [&] { return stopping_ || queued_.load(std::memory_order_acquire) != 0; });
+                if (stopping_ && queued_.load(std::memory_order_acquire) == 0) return;
+            }
+        }
+
+        static inline thread_local WorkStealingPool* currentPool_ = nullptr;
+        static inline thread_local std::size_t currentWorker_ = 0;
+
+        std::vector<WorkerQueue> queues_;
+        std::vector<std::thread> workers_;
+        std::mutex sleepMutex_;
+        std::condition_variable sleepCv_;
+        std::condition_variable doneCv_;
+        std::atomic<std::size_t> queued_{0};
+        std::atomic<std::size_t> unfinished_{0};
+        std::atomic<std::size_t> nextQueue_{0};
+        std::atomic<std::uint64_t> steals_{0};
+        std::exception_ptr error_;
+        bool stopping_ = false;
+    };
+}
@@ -1,17 +1,24 @@
-# pragma once
-#include <cstdint>
-#include <cstddef>
-#include <vector>
-
-namespace tci {   
-    using TraceBytes = std::vector<std::uint8_t>;
-    
-    class TraceBytesConnect {
-        public:
-        virtual ~TraceBytesConnect() = default;
-        virtual void pushBytes(const std::uint8_t* data, std::size_t n) = 0;
-        
-        // Convenience overload
-        void pushBytes(const TraceBytes& b) { pushBytes(b.data(), b.size()); }
-    };
+# pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+namespace tci {   
+    using TraceBytes = std::vector<std::uint8_t>;
+    
+    class TraceBytesConnect {
+        public:
+        virtual ~TraceBytesConnect() = default;
+        // Returns false if any of the n bytes were dropped because a buffer or queue was full (overflow);
+        // the producer reports this as trTeInstStallOrOverflow. Bytes discarded on purpose (component
+        // disabled, input masked, nothing connected) are counted by that component and return true.
+        virtual bool pushBytes(const std::uint8_t* data, std::size_t n) = 0;
+
+        // Producer with trTeInstStallEna set: connectors that can wait for room (input queues, stream
+        // buffers) stall instead of dropping, whatever their own backpressure setting. Default: pushBytes.
+        virtual bool pushBytesStalling(const std::uint8_t* data, std::size_t n) { return pushBytes(data, n); }
+        
+        // Convenience overload
+        bool pushBytes(const TraceBytes& b) { return pushBytes(b.data(), b.size()); }
+    };
 }
\ No newline at end of file
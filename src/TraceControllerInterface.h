@@ -1,141 +1,635 @@
-#pragma once
-#include <cstdint>
-#include <vector>
-#include <cassert>
-
-#include "IHwAccess.h"
-#include "TraceControlRegisters.h"
-
-
-namespace tci {
-    class TraceControllerInterface {
-    public:
-            TraceControllerInterface(IHwAccess& hw, uint32_t teBase, uint32_t funnelBase, uint32_t ramSinkBase)
-                : hw_(hw), trTeBase_(teBase), trFunnelBase_(funnelBase), trRamSinkBase_(ramSinkBase) {}
-                
-    public:
-    static void expectBits(uint32_t got, uint32_t mask, bool should_set) {
-        if(should_set) assert((got & mask) == mask);
-        else assert((got & mask) == 0);
-    }
-    
-    static inline uint32_t bitFieldGet(uint32_t reg, uint32_t mask, uint32_t shift) {
-        return (reg & mask) >> shift;
-    }
-    static inline uint32_t bitFieldSet(uint32_t reg, uint32_t mask, uint32_t shift, uint32_t v) {
-        reg &= ~mask;
-        reg |= (v << shift) & mask;
-        return reg;
-    }
-    
-    // Driver API:
-    
-    void configure() {        
-        // Configure trRamControl:
-        uint32_t trRamControlValue = tci::tr_ram::TR_RAM_ACTIVE | tci::tr_ram::TR_RAM_ENABLE;
-        hw_.WriteMemory(trRamSinkBase_ + tci::tr_ram::TR_RAM_CONTROL, trRamControlValue);
-        // Assertions to check the write
-        uint32_t ramReadBackValue = hw_.ReadMemory(trRamSinkBase_ + tci::tr_ram::TR_RAM_CONTROL);
-        expectBits(ramReadBackValue, tci::tr_ram::TR_RAM_ACTIVE, true);
-        expectBits(ramReadBackValue, tci::tr_ram::TR_RAM_ENABLE, true);
-        // std::cout << "[TraceControllerInterface::configure] TraceRamSink configured with Active and Enable set" << std::endl;
-        
-        // Configure trFunnelControl:
-        uint32_t trFunnelControlValue = tci::tr_tf::TR_FUNNEL_ACTIVE | tci::tr_tf::TR_FUNNEL_ENABLE;
-        hw_.WriteMemory(trFunnelBase_ + tci::tr_tf::TR_FUNNEL_CONTROL, trFunnelControlValue);
-        // Assertions to check the write
-        uint32_t funnelReadBackValue = hw_.ReadMemory(trFunnelBase_ + tci::tr_tf::TR_FUNNEL_CONTROL);
-        expectBits(funnelReadBackValue, tci::tr_tf::TR_FUNNEL_ACTIVE, true);
-        expectBits(funnelReadBackValue, tci::tr_tf::TR_FUNNEL_ENABLE, true);
-        // std::cout << "[TraceControllerInterface::configure] TraceFunnel configured with Active and Enable set" << std::endl;
-
-        // Configure trFunnelDisInput:
-        uint32_t trFunnelDisInputValue = ( 0x0u & tci::tr_tf::TR_FUNNEL_DIS_INPUT_MASK); // 0 - enables all inputs to the funnel; 1 - disables
-        hw_.WriteMemory(trFunnelBase_ + tci::tr_tf::TR_FUNNEL_DIS_INPUT, trFunnelDisInputValue);
-        // Assertion to check the write
-        uint32_t funnelDisInputReadBackValue = hw_.ReadMemory(trFunnelBase_ + tci::tr_tf::TR_FUNNEL_DIS_INPUT);
-        assert(bitFieldGet(funnelDisInputReadBackValue, tci::tr_tf::TR_FUNNEL_DIS_INPUT_MASK, 0) == 0x0u);
-        // std::cout << "[TraceControllerInterface::configure] TraceFunnel input enabled (trFunnelDisInput set to 0)" << std::endl;
-        
-
-        // Configure trEncoderControl:
-        // enable trTeActive and trTeEnable, set trTeFormat to 0 (default)
-        // since we configure, direct write without read
-        // TR_TE_INST_TRACING set to start/stop instruction trace output from TraceEncoder
-        uint32_t trTeControlValue = tci::tr_te::TR_TE_ACTIVE |  tci::tr_te::TR_TE_INST_TRACING  
-                                    | ((0x5u << tci::tr_te::TR_TE_FORMAT_SHIFT) & tci::tr_te::TR_TE_FORMAT_MASK)
-                                    | ((0x3u << tci::tr_te::TR_TE_INST_MODE_SHIFT) & tci::tr_te::TR_TE_INST_MODE_MASK)
-                                    | ((0x3u << tci::tr_te::TR_TE_INST_SYNC_MODE_SHIFT) & tci::tr_te::TR_TE_INST_SYNC_MODE_MASK);
-        hw_.WriteMemory(trTeBase_ + tci::tr_te::TR_TE_CONTROL, trTeControlValue);
-        // Assertions to check the write
-        uint32_t readBackValue = hw_.ReadMemory(trTeBase_ + tci::tr_te::TR_TE_CONTROL);
-        expectBits(readBackValue, tci::tr_te::TR_TE_ACTIVE, true);
-        expectBits(readBackValue, tci::tr_te::TR_TE_INST_TRACING, true);
-        // uint32_t readBackFormat = hw_.ReadMemory(trTeBase_ + tci::tr_te::TR_TE_CONTROL);
-        assert(bitFieldGet(readBackValue, tci::tr_te::TR_TE_FORMAT_MASK, tci::tr_te::TR_TE_FORMAT_SHIFT) == 0x5u);
-        assert(bitFieldGet(readBackValue, tci::tr_te::TR_TE_INST_MODE_MASK, tci::tr_te::TR_TE_INST_MODE_SHIFT) == 0x3u);
-        assert(bitFieldGet(readBackValue, tci::tr_te::TR_TE_INST_SYNC_MODE_MASK, tci::tr_te::TR_TE_INST_SYNC_MODE_SHIFT) == 0x3u);
-        // std::cout << "[TraceControllerInterface::configure] TraceEncoder configured with Active, InstTracing enabled and Format set to 0x5" << std::endl;
-    }
-    
-    void start() {
-        // Configure trEncoderControl to start producing trace data:
-        // Read-Modify-Write to set the Enable bit while keeping other bits unchanged
-        uint32_t trTeControlValue = hw_.ReadMemory(trTeBase_ + tci::tr_te::TR_TE_CONTROL) | tci::tr_te::TR_TE_ENABLE;
-        hw_.WriteMemory(trTeBase_ + tci::tr_te::TR_TE_CONTROL, trTeControlValue);
-        // Assertions to check the write
-        uint32_t readBackValue = hw_.ReadMemory(trTeBase_ + tci::tr_te::TR_TE_CONTROL);
-        expectBits(readBackValue, tci::tr_te::TR_TE_ENABLE, true);
-        // std::cout << "[TraceControllerInterface::start] Trace production started by enabling TraceEncoder" << std::endl;
-
-    }
-    
-    void stop() {
-        // Disable Producer first to stop new data from being generated
-        // Disable TraceEncoder
-        uint32_t trTeControlValue = hw_.ReadMemory(trTeBase_ + tci::tr_te::TR_TE_CONTROL) & ~tci::tr_te::TR_TE_ENABLE;
-        hw_.WriteMemory(trTeBase_ + tci::tr_te::TR_TE_CONTROL, trTeControlValue);
-        // Assertions to check the write
-        uint32_t readBackValue = hw_.ReadMemory(trTeBase_ + tci::tr_te::TR_TE_CONTROL);
-        expectBits(readBackValue, tci::tr_te::TR_TE_ENABLE, false);
-
-        // Disable TraceFunnel
-        uint32_t trFunnelControlValue = hw_.ReadMemory(trFunnelBase_ + tci::tr_tf::TR_FUNNEL_CONTROL) & ~tci::tr_tf::TR_FUNNEL_ENABLE;
-        hw_.WriteMemory(trFunnelBase_ + tci::tr_tf::TR_FUNNEL_CONTROL, trFunnelControlValue);
-        // Assertions to check the write
-        uint32_t funnelReadBackValue = hw_.ReadMemory(trFunnelBase_ + tci::tr_tf::TR_FUNNEL_CONTROL);
-        expectBits(funnelReadBackValue, tci::tr_tf::TR_FUNNEL_ENABLE, false);
-
-        // Disable TraceRamSink
-        uint32_t trRamControlValue = hw_.ReadMemory(trRamSinkBase_ + tci::tr_ram::TR_RAM_CONTROL) & ~tci::tr_ram::TR_RAM_ENABLE;
-        hw_.WriteMemory(trRamSinkBase_ + tci::tr_ram::TR_RAM_CONTROL, trRamControlValue);
-        // Assertions to check the write
-        uint32_t ramReadBackValue = hw_.ReadMemory(trRamSinkBase_ + tci::tr_ram::TR_RAM_CONTROL);
-        expectBits(ramReadBackValue, tci::tr_ram::TR_RAM_ENABLE, false);
-    }
-    
-    std::vector<uint32_t> fetch(std::size_t wordCount) {
-        std::vector<uint32_t> data;
-        data.reserve(wordCount);
-
-        while(data.size() < wordCount) {
-            std::uint32_t sinkRamRP = hw_.ReadMemory(trRamSinkBase_ + tci::tr_ram::TR_RAM_RP_LOW); // read RP_LOW to see how many bytes have been read
-            std::uint32_t sinkRamWP = hw_.ReadMemory(trRamSinkBase_ + tci::tr_ram::TR_RAM_WP_LOW); // read WP_LOW to see how many bytes have been written
-            if ((sinkRamWP == sinkRamRP)) break; // no more data available
-            std::uint32_t sinkDataBufferValue = hw_.ReadMemory(trRamSinkBase_ + tci::tr_ram::TR_RAM_DATA); // advances rp by 4 bytes.  Read from TraceRamSink to see the data
-            data.push_back(sinkDataBufferValue);
-
-            // const std::uint32_t ctrl = hw_.ReadMemory(trRamSinkBase_ + tci::tr_ram::TR_RAM_CONTROL);
-            // const bool empty = (ctrl & tci::tr_ram::TR_RAM_EMPTY) != 0;
-            // if(empty) break; // no more data available
-        }
-        return data;
-    }
-
-    private:
-        IHwAccess& hw_;
-        uint32_t trTeBase_; // base address for TraceEncoder
-        uint32_t trFunnelBase_; // base address for TraceFunnel
-        uint32_t trRamSinkBase_; // base address for TraceRamSink
-    };
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <cassert>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+#include "IHwAccess.h"
+#include "TraceControlRegisters.h"
+
+
+namespace tci {
+    class TraceControllerInterface {
+    public:
+            // Read-back verification of control register writes
+            enum class VerifyPolicy {
+                Always,      // every write is read back and checked (original behavior)
+                OnConfigure, // only configure() reads back; start()/stop() trust the shadow cache
+                Never        // no read-backs (production runs)
+            };
+
+            // Controller operations, for the asynchronous interface (asyncBegin)
+            enum class Operation { None, Configure, Start, Stop, Fetch };
+
+            // Probe transactions issued by the last configure()/start()/stop(), the reads the
+            // shadow cache avoided compared to a read-modify-write + read-back sequence, and the
+            // IHwAccess::Flush() calls (probe round-trips when the probe queues accesses)
+            struct SequenceStats {
+                uint32_t reads = 0;
+                uint32_t writes = 0;
+                uint32_t readsSaved = 0;
+                uint32_t flushes = 0;
+            };
+
+            TraceControllerInterface(IHwAccess& hw, uint32_t teBase, uint32_t funnelBase, uint32_t ramSinkBase)
+                : TraceControllerInterface(hw, std::vector<uint32_t>{teBase}, funnelBase, ramSinkBase) {}
+
+            // Multi-hart system: configure()/start()/stop() program every encoder in teBases
+            TraceControllerInterface(IHwAccess& hw, std::vector<uint32_t> teBases, uint32_t funnelBase, uint32_t ramSinkBase)
+                : TraceControllerInterface(hw, std::move(teBases), std::vector<uint32_t>{funnelBase}, ramSinkBase) {}
+
+            // Funnel tree: funnelBases root first (parents before children, e.g. TraceSystem::funnelBases());
+            // configure() enables funnels root first, stop() disables them leaves first so queued data drains to the sink
+            TraceControllerInterface(IHwAccess& hw, std::vector<uint32_t> teBases, std::vector<uint32_t> funnelBases, uint32_t ramSinkBase)
+                : hw_(hw), trTeBases_(std::move(teBases)), trFunnelBases_(std::move(funnelBases)), trRamSinkBase_(ramSinkBase),
+                  teShadow_(trTeBases_.size()), funnelControlShadow_(trFunnelBases_.size()), funnelDisInputShadow_(trFunnelBases_.size()) {
+                if (trTeBases_.empty()) throw std::invalid_argument("TraceControllerInterface needs at least one encoder");
+                if (trFunnelBases_.empty()) throw std::invalid_argument("TraceControllerInterface needs at least one funnel");
+                readBacks_.reserve(1 + 2 * trFunnelBases_.size() + trTeBases_.size()); // most read-backs of one sequence
+            }
+
+            ~TraceControllerInterface() {
+                stopContinuousCapture();
+            }
+
+            TraceControllerInterface(const TraceControllerInterface&) = delete;
+            TraceControllerInterface& operator=(const TraceControllerInterface&) = delete;
+                
+    public:
+    static void expectBits(uint32_t got, uint32_t mask, bool should_set) {
+        if(should_set) assert((got & mask) == mask);
+        else assert((got & mask) == 0);
+    }
+    
+    static inline uint32_t bitFieldGet(uint32_t reg, uint32_t mask, uint32_t shift) {
+        return (reg & mask) >> shift;
+    }
+    static inline uint32_t bitFieldSet(uint32_t reg, uint32_t mask, uint32_t shift, uint32_t v) {
+        reg &= ~mask;
+        reg |= (v << shift) & mask;
+        return reg;
+    }
+    
+    // Driver API:
+    
+    // Select SMEM mode for the sink: configure() then programs trRamStartLow/trRamLimitLow
+    // with [startAddress, limitAddress) and sets TR_RAM_MODE. Addresses must be 4-byte aligned.
+    void setSinkSmem(uint32_t startAddress, uint32_t limitAddress) {
+        sinkSmem_ = true;
+        smemStart_ = startAddress;
+        smemLimit_ = limitAddress;
+    }
+
+    // trTeFormat programmed by configure(): default 0x5 (raw records), tr_te::TR_TE_FORMAT_DELTA for the compressed format
+    void setTraceFormat(uint32_t format) {
+        traceFormat_ = format & tci::tr_te::TR_TE_FORMAT_FIELD.valueMask();
+    }
+
+    // trTeInstSyncMode/trTeInstSyncMax programmed by configure() (default mode 0x3, max 0).
+    // Delta format emits a SYNC packet every 2^(max + 4) units: 1 = trace bytes, 2 = instructions, 3 = halfwords, 0 = off.
+    void setInstSync(uint32_t mode, uint32_t max) {
+        instSyncMode_ = mode & tci::tr_te::TR_TE_INST_SYNC_MODE_FIELD.valueMask();
+        instSyncMax_ = max & tci::tr_te::TR_TE_INST_SYNC_MAX_FIELD.valueMask();
+    }
+
+    // trTeInstStallEna programmed by configure() (default off): encoders stall on a full downstream
+    // queue or stream buffer instead of dropping trace (trTeInstStallOrOverflow reports drops only)
+    void setInstStall(bool enable) { instStall_ = enable; }
+
+    // Sequences are issued through the deferred IHwAccess interface: writes and read-backs are queued
+    // and run in one flush; start()/stop() need a second one (first) only for control registers that
+    // are not in the shadow cache. Read-backs are checked once the flush returns.
+    void configure() { runSequence(Operation::Configure); }
+    
+    void start() { runSequence(Operation::Start); }
+    
+    void stop() { runSequence(Operation::Stop); }
+
+    // Asynchronous operations: the same sequences (and fetchBulk) as split-phase state machines, so one
+    // thread can keep many controllers in flight and overlap their probe latency (see ControllerScheduler).
+    // asyncBegin() queues the first batch and starts its flush (IHwAccess::BeginFlush). Once asyncReady(),
+    // asyncStep() completes that flush and starts the next batch; it returns true when the operation is done.
+    // Fetch drains into dst (up to maxWords) like fetchBulk; asyncFetched() is the word count. One operation at a time.
+    // Not available while a continuous capture runs: its drainer owns the probe between flushes.
+    void asyncBegin(Operation op, std::uint32_t* dst = nullptr, std::size_t maxWords = 0) {
+        assert(asyncOp_ == Operation::None && op != Operation::None);
+        if (drainer_.joinable()) throw std::logic_error("TraceControllerInterface: async operation during continuous capture");
+        if (op == Operation::Fetch) openFetch(asyncFetch_, dst, maxWords);
+        else openSequence(op);
+        asyncOp_ = op;
+        hw_.BeginFlush();
+    }
+
+    bool asyncReady() { return hw_.FlushReady(); }
+
+    bool asyncStep() {
+        assert(asyncOp_ != Operation::None);
+        bool done;
+        try {
+            hw_.EndFlush();
+            done = (asyncOp_ == Operation::Fetch) ? fetchFlushed(asyncFetch_) : sequenceFlushed();
+        } catch (...) {
+            asyncOp_ = Operation::None;
+            throw;
+        }
+        if (!done) {
+            hw_.BeginFlush();
+            return false;
+        }
+        if (asyncOp_ == Operation::Fetch) lastFetchWrapped_.store(asyncFetch_.wrapped, std::memory_order_relaxed);
+        asyncOp_ = Operation::None;
+        return true;
+    }
+
+    bool asyncBusy() const { return asyncOp_ != Operation::None; }
+    std::size_t asyncFetched() const { return asyncFetch_.total; }
+
+    void setVerifyPolicy(VerifyPolicy policy) { verifyPolicy_ = policy; }
+    VerifyPolicy verifyPolicy() const { return verifyPolicy_; }
+
+    // Drop all cached control values (e.g. another tool or a reset touched the registers);
+    // the next read-modify-write reads the register from the probe again
+    void invalidateShadow() {
+        for (auto& reg : shadow_) reg.valid = false;
+        for (auto& reg : teShadow_) reg.valid = false;
+        for (auto& reg : funnelControlShadow_) reg.valid = false;
+        for (auto& reg : funnelDisInputShadow_) reg.valid = false;
+    }
+
+    const SequenceStats& lastSequenceStats() const { return stats_; }
+    
+    std::vector<uint32_t> fetch(std::size_t wordCount) {
+        std::vector<uint32_t> data;
+        data.reserve(wordCount);
+        std::lock_guard<std::mutex> lock(hwMutex_);
+
+        while(data.size() < wordCount) {
+            std::uint32_t sinkRamRP = hw_.ReadMemory(trRamSinkBase_ + tci::tr_ram::TR_RAM_RP_LOW); // read RP_LOW to see how many bytes have been read
+            std::uint32_t sinkRamWP = hw_.ReadMemory(trRamSinkBase_ + tci::tr_ram::TR_RAM_WP_LOW); // read WP_LOW to see how many bytes have been written
+            if ((sinkRamWP == sinkRamRP)) break; // no more data available
+            std::uint32_t sinkDataBufferValue = hw_.ReadMemory(trRamSinkBase_ + tci::tr_ram::TR_RAM_DATA); // advances rp by 4 bytes.  Read from TraceRamSink to see the data
+            data.push_back(sinkDataBufferValue);
+
+            // const std::uint32_t ctrl = hw_.ReadMemory(trRamSinkBase_ + tci::tr_ram::TR_RAM_CONTROL);
+            // const bool empty = (ctrl & tci::tr_ram::TR_RAM_EMPTY) != 0;
+            // if(empty) break; // no more data available
+        }
+        return data;
+    }
+
+    // Bulk fetch into a caller-provided buffer (no allocation).
+    // Reads the buffer bounds and RP/WP once (one flush), computes the available word count (including wrap),
+    // drains that many words from TR_RAM_DATA with a single fixed-address burst and re-polls RP/WP in the
+    // same flush as the burst. Returns the number of words written to dst.
+    std::size_t fetchBulk(std::uint32_t* dst, std::size_t maxWords) {
+        std::lock_guard<std::mutex> lock(hwMutex_);
+        FetchState f;
+        openFetch(f, dst, maxWords);
+        do hw_.Flush(); while (!fetchFlushed(f));
+        lastFetchWrapped_.store(f.wrapped, std::memory_order_relaxed);
+        return f.total;
+    }
+
+    // True if the last fetchBulk saw TR_RAM_WRAP set (older data may have been overwritten)
+    bool lastFetchWrapped() const { return lastFetchWrapped_.load(std::memory_order_relaxed); }
+
+    // Continuous capture: a drainer thread calls fetchBulk in a loop while tracing is live and
+    // hands every chunk to `consumer` (called on the drainer thread). When the sink is empty it
+    // sleeps for pollInterval; call after configure()/start(). The drainer shares the probe with the
+    // blocking calls: each fetchBulk and each configure()/start()/stop() holds the probe for its whole
+    // batch sequence, so stop() may be called while the capture runs (the async API may not).
+    using CaptureConsumer = std::function<void(const uint32_t* words, std::size_t count)>;
+
+    void startContinuousCapture(CaptureConsumer consumer, std::size_t chunkWords = 4096,
+                                std::chrono::microseconds pollInterval = std::chrono::microseconds(50)) {
+        assert(!drainer_.joinable()); // one capture at a time
+        assert(asyncOp_ == Operation::None);
+        assert(chunkWords != 0);
+        capturedWords_ = 0;
+        captureRunning_ = true;
+        drainer_ = std::thread([this, consumer = std::move(consumer), chunkWords, pollInterval] {
+            std::vector<uint32_t> chunk(chunkWords);
+            bool running = true;
+            while (running) {
+                running = captureRunning_.load(std::memory_order_acquire);
+                // Once stop was requested, keep draining until the sink is empty (final drain)
+                std::size_t n;
+                while ((n = fetchBulk(chunk.data(), chunk.size())) != 0) {
+                    consumer(chunk.data(), n);
+                    capturedWords_.fetch_add(n, std::memory_order_relaxed);
+                }
+                if (running) std::this_thread::sleep_for(pollInterval);
+            }
+        });
+    }
+
+    // Stop the drainer after a final drain. Call stop() (or stop emitting) first so that no
+    // data arrives after the last poll.
+    void stopContinuousCapture() {
+        if (!drainer_.joinable()) return;
+        captureRunning_.store(false, std::memory_order_release);
+        drainer_.join();
+    }
+
+    // Words delivered to the consumer by the current/last continuous capture
+    std::uint64_t capturedWords() const { return capturedWords_.load(std::memory_order_relaxed); }
+
+    private:
+    // Shadow cache of the control registers. Only RW bits are cached: RO status (EMPTY) and
+    // RW1C bits (trTeInstStallOrOverflow) are owned by the hardware and always read live.
+    // Writes from the cache carry 0 in RW1C bits, so a read-modify-write never clears status by accident.
+    enum ShadowId { TeControl, FunnelControl, FunnelDisInput, RamControl, ShadowCount };
+
+    struct ShadowReg {
+        uint32_t value = 0;
+        bool valid = false;
+        bool prefetched = false; // filled by prefetchControl() for the current sequence
+    };
+
+    // Read-back queued by the current sequence; value is filled in by flush()
+    struct ReadBack {
+        ShadowId id;
+        std::size_t unit;
+        uint32_t value;
+    };
+
+    // TeControl exists once per encoder, the funnel registers once per funnel (index `unit`);
+    // RamControl once per system
+    ShadowReg& shadowReg(ShadowId id, std::size_t unit) {
+        switch (id) {
+            case TeControl:      return teShadow_[unit];
+            case FunnelControl:  return funnelControlShadow_[unit];
+            case FunnelDisInput: return funnelDisInputShadow_[unit];
+            default:             return shadow_[id];
+        }
+    }
+
+    uint32_t shadowAddress(ShadowId id, std::size_t unit) const {
+        switch (id) {
+            case TeControl:      return trTeBases_[unit] + tci::tr_te::TR_TE_CONTROL;
+            case FunnelControl:  return trFunnelBases_[unit] + tci::tr_tf::TR_FUNNEL_CONTROL;
+            case FunnelDisInput: return trFunnelBases_[unit] + tci::tr_tf::TR_FUNNEL_DIS_INPUT;
+            default:             return trRamSinkBase_ + tci::tr_ram::TR_RAM_CONTROL;
+        }
+    }
+
+    static const reg::Register& shadowRegister(ShadowId id) {
+        switch (id) {
+            case TeControl:      return tci::tr_te::TR_TE_CONTROL_REG;
+            case FunnelControl:  return tci::tr_tf::TR_FUNNEL_CONTROL_REG;
+            case FunnelDisInput: return tci::tr_tf::TR_FUNNEL_DIS_INPUT_REG;
+            default:             return tci::tr_ram::TR_RAM_CONTROL_REG;
+        }
+    }
+
+    static uint32_t shadowRwMask(ShadowId id) { return shadowRegister(id).writableMask(); }
+
+    // Queue the read of a control register missing from the cache; applyPrefetch() fills it in
+    void prefetchControl(ShadowId id, std::size_t unit = 0) {
+        ShadowReg& reg = shadowReg(id, unit);
+        if (reg.valid || reg.prefetched) return;
+        reg.prefetched = true;
+        ++stats_.reads;
+        hw_.QueueRead(shadowAddress(id, unit), &reg.value);
+        prefetched_.push_back({id, unit, 0});
+    }
+
+    void applyPrefetch() {
+        for (const ReadBack& p : prefetched_) {
+            ShadowReg& reg = shadowReg(p.id, p.unit);
+            reg.value &= shadowRwMask(p.id);
+            reg.valid = true;
+        }
+        prefetched_.clear();
+    }
+
+    // RW bits for a read-modify-write: from the cache when valid, otherwise from the probe
+    uint32_t readControl(ShadowId id, std::size_t unit = 0) {
+        ShadowReg& reg = shadowReg(id, unit);
+        if (reg.valid) {
+            if (reg.prefetched) reg.prefetched = false; // the read was counted by prefetchControl()
+            else ++stats_.readsSaved;
+            return reg.value;
+        }
+        reg.value = hwRead(shadowAddress(id, unit)) & shadowRwMask(id);
+        reg.valid = true;
+        return reg.value;
+    }
+
+    void writeControl(ShadowId id, uint32_t value, std::size_t unit = 0) {
+        value &= shadowRwMask(id);
+        hwWrite(shadowAddress(id, unit), value);
+        // Clearing ACTIVE (bit 0 of every control register) resets the component to all-zero RW bits
+        const bool resets = (id != FunnelDisInput) && (value & 0x1u) == 0;
+        ShadowReg& reg = shadowReg(id, unit);
+        reg.value = resets ? 0u : value;
+        reg.valid = true;
+    }
+
+    // Verification read of the full register value, queued behind the write it checks
+    void queueReadBack(ShadowId id, std::size_t unit = 0) {
+        assert(readBacks_.size() < readBacks_.capacity()); // QueueRead keeps a pointer into readBacks_
+        readBacks_.push_back({id, unit, 0});
+        ++stats_.reads;
+        hw_.QueueRead(shadowAddress(id, unit), &readBacks_.back().value);
+    }
+
+    void skipReadBack() { ++stats_.readsSaved; }
+
+    void beginSequence() {
+        stats_ = SequenceStats{};
+        readBacks_.clear();
+        for (const ReadBack& p : prefetched_) shadowReg(p.id, p.unit).prefetched = false; // left over by a failed flush
+        prefetched_.clear();
+    }
+
+    // Read-back RW bits refresh the cache (WARL fields may be adjusted)
+    void applyReadBacks() {
+        for (const ReadBack& rb : readBacks_) {
+            ShadowReg& reg = shadowReg(rb.id, rb.unit);
+            reg.value = rb.value & shadowRwMask(rb.id);
+            reg.valid = true;
+        }
+    }
+
+    uint32_t hwRead(uint32_t address) {
+        ++stats_.reads;
+        return hw_.ReadMemory(address);
+    }
+
+    void hwWrite(uint32_t address, uint32_t value) {
+        ++stats_.writes;
+        hw_.QueueWrite(address, value);
+    }
+
+    // Number of whole words between RP and WP within [start, limit).
+    // WP == RP is ambiguous (empty or full); on the first poll TR_RAM_EMPTY (in ctrl) resolves it,
+    // on re-polls right after a drain it is treated as empty.
+    static std::size_t availableWords(std::uint32_t start, std::uint32_t limit, std::uint32_t rpLow, std::uint32_t wpLow,
+                                      std::uint32_t ctrl, bool checkFull) {
+        const std::uint32_t rp = rpLow & tci::tr_ram::TR_RAM_RP_LOW_MASK;
+        const std::uint32_t wp = wpLow & tci::tr_ram::TR_RAM_WP_LOW_MASK;
+        const std::uint32_t capacity = limit - start;
+
+        std::uint32_t bytes = 0;
+        if (wp > rp) {
+            bytes = wp - rp;
+        } else if (wp < rp) {
+            bytes = capacity - (rp - wp); // WP wrapped around the end of the buffer
+        } else if (checkFull) {
+            if ((ctrl & tci::tr_ram::TR_RAM_EMPTY) == 0) bytes = capacity;
+        }
+        return bytes / 4;
+    }
+
+    // fetchBulk as a state machine: each call of fetchFlushed() consumes one flushed batch and queues the next
+    struct FetchState {
+        std::uint32_t* dst = nullptr;
+        std::size_t maxWords = 0;
+        std::size_t total = 0;
+        std::uint32_t start = 0, limit = 0, rp = 0, wpLow = 0, ctrl = 0;
+        bool firstPoll = true;
+        bool full = false;    // dst is full: no re-poll
+        bool wrapped = false; // TR_RAM_WRAP seen
+        bool acking = false;  // wrap acknowledge queued
+    };
+
+    void openFetch(FetchState& f, std::uint32_t* dst, std::size_t maxWords) {
+        f = FetchState{};
+        f.dst = dst;
+        f.maxWords = maxWords;
+        f.full = (maxWords == 0);
+        hw_.QueueRead(trRamSinkBase_ + tci::tr_ram::TR_RAM_START_LOW, &f.start);
+        hw_.QueueRead(trRamSinkBase_ + tci::tr_ram::TR_RAM_LIMIT_LOW, &f.limit);
+        hw_.QueueRead(trRamSinkBase_ + tci::tr_ram::TR_RAM_RP_LOW, &f.rp);
+        hw_.QueueRead(trRamSinkBase_ + tci::tr_ram::TR_RAM_WP_LOW, &f.wpLow);
+        hw_.QueueRead(trRamSinkBase_ + tci::tr_ram::TR_RAM_CONTROL, &f.ctrl);
+    }
+
+    // True when the fetch is complete
+    bool fetchFlushed(FetchState& f) {
+        if (f.acking) return true;
+        std::size_t available = 0;
+        if (f.firstPoll) {
+            f.start &= tci::tr_ram::TR_RAM_START_LOW_MASK;
+            f.limit &= tci::tr_ram::TR_RAM_LIMIT_LOW_MASK;
+        }
+        if (!f.full) {
+            if (f.wpLow & tci::tr_ram::TR_RAM_WRAP) f.wrapped = true;
+            available = availableWords(f.start, f.limit, f.rp, f.wpLow, f.ctrl, f.firstPoll);
+        }
+        f.firstPoll = false;
+
+        if (available != 0) {
+            const std::size_t burst = (available < f.maxWords - f.total) ? available : (f.maxWords - f.total);
+            hw_.QueueReadBlock(trRamSinkBase_ + tci::tr_ram::TR_RAM_DATA, f.dst + f.total, burst, true); // advances RP by 4 bytes per word
+            f.total += burst;
+            if (f.total < f.maxWords) {
+                hw_.QueueRead(trRamSinkBase_ + tci::tr_ram::TR_RAM_RP_LOW, &f.rp);
+                hw_.QueueRead(trRamSinkBase_ + tci::tr_ram::TR_RAM_WP_LOW, &f.wpLow);
+            } else {
+                f.full = true;
+            }
+            return false;
+        }
+
+        // After a wrap the sink keeps RP on the oldest valid word, so the drain above already
+        // started there; acknowledge the wrap so the next fetch can detect a new one. The ack carries
+        // the last polled WP, so the sink keeps a wrap that happened since. With dst full the ring
+        // still holds data and the wrap stays set for the next fetch.
+        if (f.wrapped && !f.full) {
+            hw_.QueueWrite(trRamSinkBase_ + tci::tr_ram::TR_RAM_WP_LOW, f.wpLow & tci::tr_ram::TR_RAM_WP_LOW_MASK);
+            f.acking = true;
+            return false;
+        }
+        return true;
+    }
+
+    // configure()/start()/stop() as a state machine of at most two batches
+    void runSequence(Operation op) {
+        std::lock_guard<std::mutex> lock(hwMutex_);
+        openSequence(op);
+        do hw_.Flush(); while (!sequenceFlushed());
+    }
+
+    // First batch: reads of the control registers missing from the shadow cache, or directly the writes
+    void openSequence(Operation op) {
+        beginSequence();
+        sequenceOp_ = op;
+        if (op != Operation::Configure) {
+            for (std::size_t te = 0; te < trTeBases_.size(); ++te) prefetchControl(TeControl, te);
+        }
+        if (op == Operation::Stop) {
+            for (std::size_t tf = 0; tf < trFunnelBases_.size(); ++tf) prefetchControl(FunnelControl, tf);
+            prefetchControl(RamControl);
+        }
+        if (prefetched_.empty()) queueSequenceWrites();
+    }
+
+    // True when the sequence is complete
+    bool sequenceFlushed() {
+        ++stats_.flushes;
+        if (!prefetched_.empty()) {
+            applyPrefetch();
+            queueSequenceWrites();
+            return false;
+        }
+        applyReadBacks();
+        checkReadBacks();
+        return true;
+    }
+
+    void queueSequenceWrites() {
+        if (sequenceOp_ == Operation::Configure) {
+            const bool verify = (verifyPolicy_ != VerifyPolicy::Never);
+
+            // Configure trRamControl:
+            uint32_t trRamControlValue = tci::tr_ram::TR_RAM_ACTIVE | tci::tr_ram::TR_RAM_ENABLE;
+            if (sinkSmem_) {
+                // Buffer bounds are programmed while the sink is active but not yet enabled
+                const uint32_t trRamSmemValue = tci::tr_ram::TR_RAM_ACTIVE | tci::tr_ram::TR_RAM_MODE;
+                writeControl(RamControl, trRamSmemValue);
+                hwWrite(trRamSinkBase_ + tci::tr_ram::TR_RAM_START_LOW, smemStart_ & tci::tr_ram::TR_RAM_START_LOW_MASK);
+                hwWrite(trRamSinkBase_ + tci::tr_ram::TR_RAM_LIMIT_LOW, smemLimit_ & tci::tr_ram::TR_RAM_LIMIT_LOW_MASK);
+                trRamControlValue |= tci::tr_ram::TR_RAM_MODE;
+            }
+            writeControl(RamControl, trRamControlValue);
+            if (verify) queueReadBack(RamControl); else skipReadBack();
+
+            for (std::size_t tf = 0; tf < trFunnelBases_.size(); ++tf) {
+                // Configure trFunnelControl:
+                uint32_t trFunnelControlValue = tci::tr_tf::TR_FUNNEL_ACTIVE | tci::tr_tf::TR_FUNNEL_ENABLE;
+                writeControl(FunnelControl, trFunnelControlValue, tf);
+                if (verify) queueReadBack(FunnelControl, tf); else skipReadBack();
+
+                // Configure trFunnelDisInput:
+                uint32_t trFunnelDisInputValue = ( 0x0u & tci::tr_tf::TR_FUNNEL_DIS_INPUT_MASK); // 0 - enables all inputs to the funnel; 1 - disables
+                writeControl(FunnelDisInput, trFunnelDisInputValue, tf);
+                if (verify) queueReadBack(FunnelDisInput, tf); else skipReadBack();
+            }
+
+            // Configure trEncoderControl:
+            // enable trTeActive and trTeEnable, set trTeFormat to 0 (default)
+            // since we configure, direct write without read
+            // TR_TE_INST_TRACING set to start/stop instruction trace output from TraceEncoder
+            uint32_t trTeControlValue = tci::tr_te::TR_TE_ACTIVE |  tci::tr_te::TR_TE_INST_TRACING  
+                                        | (instStall_ ? tci::tr_te::TR_TE_INST_STALL_ENA : 0u)
+                                        | tci::tr_te::TR_TE_FORMAT_FIELD.place(traceFormat_)
+                                        | tci::tr_te::TR_TE_INST_MODE_FIELD.place(0x3u)
+                                        | tci::tr_te::TR_TE_INST_SYNC_MODE_FIELD.place(instSyncMode_)
+                                        | tci::tr_te::TR_TE_INST_SYNC_MAX_FIELD.place(instSyncMax_);
+            for (std::size_t te = 0; te < trTeBases_.size(); ++te) {
+                writeControl(TeControl, trTeControlValue, te);
+                if (verify) queueReadBack(TeControl, te); else skipReadBack();
+            }
+            return;
+        }
+
+        const bool verify = (verifyPolicy_ == VerifyPolicy::Always);
+        if (sequenceOp_ == Operation::Start) {
+            // Configure trEncoderControl to start producing trace data:
+            // Read-Modify-Write to set the Enable bit while keeping other bits unchanged (read served by the shadow cache)
+            for (std::size_t te = 0; te < trTeBases_.size(); ++te) {
+                uint32_t trTeControlValue = readControl(TeControl, te) | tci::tr_te::TR_TE_ENABLE;
+                writeControl(TeControl, trTeControlValue, te);
+                if (verify) queueReadBack(TeControl, te); else skipReadBack();
+            }
+            return;
+        }
+
+        // Stop: disable Producer first to stop new data from being generated
+        // Disable TraceEncoder
+        for (std::size_t te = 0; te < trTeBases_.size(); ++te) {
+            uint32_t trTeControlValue = readControl(TeControl, te) & ~tci::tr_te::TR_TE_ENABLE;
+            writeControl(TeControl, trTeControlValue, te);
+            if (verify) queueReadBack(TeControl, te); else skipReadBack();
+        }
+
+        // Disable TraceFunnel(s), leaves first
+        for (std::size_t tf = trFunnelBases_.size(); tf-- > 0;) {
+            uint32_t trFunnelControlValue = readControl(FunnelControl, tf) & ~tci::tr_tf::TR_FUNNEL_ENABLE;
+            writeControl(FunnelControl, trFunnelControlValue, tf);
+            if (verify) queueReadBack(FunnelControl, tf); else skipReadBack();
+        }
+
+        // Disable TraceRamSink
+        uint32_t trRamControlValue = readControl(RamControl) & ~tci::tr_ram::TR_RAM_ENABLE;
+        writeControl(RamControl, trRamControlValue);
+        if (verify) queueReadBack(RamControl); else skipReadBack();
+    }
+
+    // Assertions to check the writes of the sequence
+    void checkReadBacks() const {
+        for (const ReadBack& rb : readBacks_) {
+            if (sequenceOp_ == Operation::Configure) {
+                switch (rb.id) {
+                    case RamControl:
+                        expectBits(rb.value, tci::tr_ram::TR_RAM_ACTIVE, true);
+                        expectBits(rb.value, tci::tr_ram::TR_RAM_ENABLE, true);
+                        expectBits(rb.value, tci::tr_ram::TR_RAM_MODE, sinkSmem_);
+                        break;
+                    case FunnelControl:
+                        expectBits(rb.value, tci::tr_tf::TR_FUNNEL_ACTIVE, true);
+                        expectBits(rb.value, tci::tr_tf::TR_FUNNEL_ENABLE, true);
+                        break;
+                    case FunnelDisInput:
+                        assert(tci::tr_tf::TR_FUNNEL_DIS_INPUT_FIELD.get(rb.value) == 0x0u);
+                        break;
+                    default:
+                        expectBits(rb.value, tci::tr_te::TR_TE_ACTIVE, true);
+                        expectBits(rb.value, tci::tr_te::TR_TE_INST_TRACING, true);
+                        assert(tci::tr_te::TR_TE_FORMAT_FIELD.get(rb.value) == traceFormat_);
+                        assert(tci::tr_te::TR_TE_INST_MODE_FIELD.get(rb.value) == 0x3u);
+                        assert(tci::tr_te::TR_TE_INST_SYNC_MODE_FIELD.get(rb.value) == instSyncMode_);
+                        assert(tci::tr_te::TR_TE_INST_SYNC_MAX_FIELD.get(rb.value) == instSyncMax_);
+                }
+                continue;
+            }
+            const bool enabled = (sequenceOp_ == Operation::Start);
+            switch (rb.id) {
+                case TeControl:     expectBits(rb.value, tci::tr_te::TR_TE_ENABLE, enabled); break;
+                case FunnelControl: expectBits(rb.value, tci::tr_tf::TR_FUNNEL_ENABLE, enabled); break;
+                default:            expectBits(rb.value, tci::tr_ram::TR_RAM_ENABLE, enabled);
+            }
+        }
+    }
+
+    private:
+        IHwAccess& hw_;
+        std::vector<uint32_t> trTeBases_; // base address of each TraceEncoder
+        std::vector<uint32_t> trFunnelBases_; // base address of each TraceFunnel, root first
+        uint32_t trRamSinkBase_; // base address for TraceRamSink
+        std::atomic<bool> lastFetchWrapped_{false}; // written by the continuous-capture drainer
+        std::mutex hwMutex_; // one batch sequence on hw_ at a time (blocking calls vs. the drainer)
+
+        bool sinkSmem_ = false; // TR_RAM_MODE: false = SRAM, true = SMEM
+        uint32_t smemStart_ = 0;
+        uint32_t smemLimit_ = 0;
+        uint32_t traceFormat_ = 0x5u;
+        uint32_t instSyncMode_ = 0x3u;
+        uint32_t instSyncMax_ = 0x0u;
+        bool instStall_ = false;
+
+        VerifyPolicy verifyPolicy_ = VerifyPolicy::Always;
+        ShadowReg shadow_[ShadowCount];
+        std::vector<ShadowReg> teShadow_; // TeControl, one per encoder
+        std::vector<ShadowReg> funnelControlShadow_; // one per funnel
+        std::vector<ShadowReg> funnelDisInputShadow_;
+        std::vector<ReadBack> readBacks_; // current sequence
+        std::vector<ReadBack> prefetched_;
+        SequenceStats stats_;
+        Operation sequenceOp_ = Operation::None; // sequence being issued
+        Operation asyncOp_ = Operation::None;    // asyncBegin() operation in flight
+        FetchState asyncFetch_;
+
+        std::thread drainer_; // continuous capture
+        std::atomic<bool> captureRunning_{false};
+        std::atomic<std::uint64_t> capturedWords_{0};
+    };
 }
\ No newline at end of file
@@ -0,0 +1,272 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+#include <cstring>
+#include <string>
+#include <future>
+#include <map>
+
+#include "TracePacket.h"
+#include "ThreadPool.h"
+#include "RawPackKernels.h"
+#include "MappedFileMemory.h"
+
+namespace tci {
+    struct DecodedInstruction {
+        std::uint32_t pc;
+        std::uint32_t opcode;
+    };
+
+    // Offline decoder for the trace formats produced by TraceEncoder.
+    // The delta format carries no opcodes; an optional lookup (e.g. into the program image)
+    // fills them in, otherwise they decode as 0.
+    class TraceDecoder {
+    public:
+        using OpcodeLookup = std::function<std::uint32_t(std::uint32_t pc)>;
+
+        enum class Format { Raw, Delta };
+
+        // The lookup is called concurrently by decodeParallel and must be thread-safe
+        explicit TraceDecoder(OpcodeLookup lookup = nullptr) : lookup_(std::move(lookup)) {}
+
+        // Raw format: 8-byte little-endian (pc, opcode) records
+        static void decodeRaw(const std::uint8_t* data, std::size_t size, std::vector<DecodedInstruction>& out) {
+            out.reserve(out.size() + size / 8);
+            for (std::size_t i = 0; i + 8 <= size; i += 8) {
+                out.push_back({load_u32_le(data + i), load_u32_le(data + i + 4)});
+            }
+        }
+
+        // Delta format. Throws std::runtime_error on malformed input (truncated packet,
+        // RUN/DELTA before the first ADDRESS).
+        void decodeDelta(const std::uint8_t* data, std::size_t size, std::vector<DecodedInstruction>& out) const {
+            std::size_t pos = 0;
+            std::uint32_t pc = 0;
+            bool haveAddress = false;
+            while (pos < size) {
+                if (data[pos] == packet::SYNC_MARKER[0]) { // SYNC (header 0xFF is reserved for it)
+                    if (pos + packet::SYNC_BYTES > size ||
+                        std::memcmp(data + pos, packet::SYNC_MARKER, packet::SYNC_MARKER_BYTES) != 0) {
+                        throw std::runtime_error("TraceDecoder: malformed sync packet");
+                    }
+                    pc = load_u32_le(data + pos + packet::SYNC_MARKER_BYTES);
+                    pos += packet::SYNC_BYTES;
+                    haveAddress = true;
+                    emit(pc, out);
+                    continue;
+                }
+                std::uint8_t type = 0;
+                std::uint32_t value = 0;
+                if (!packet::get(data, size, pos, type, value)) {
+                    throw std::runtime_error("TraceDecoder: truncated packet");
+                }
+                switch (type) {
+                    case packet::TYPE_PAD:
+                        break;
+                    case packet::TYPE_ADDRESS:
+                        if (pos + 4 > size) throw std::runtime_error("TraceDecoder: truncated address packet");
+                        pc = load_u32_le(data + pos);
+                        pos += 4;
+                        haveAddress = true;
+                        emit(pc, out);
+                        break;
+                    case packet::TYPE_RUN:
+                        if (!haveAddress) throw std::runtime_error("TraceDecoder: run before address");
+                        for (std::uint32_t i = 0; i < value; ++i) {
+                            pc += packet::INST_BYTES;
+                            emit(pc, out);
+                        }
+                        break;
+                    default: // TYPE_DELTA
+                        if (!haveAddress) throw std::runtime_error("TraceDecoder: delta before address");
+                        pc += packet::INST_BYTES + static_cast<std::uint32_t>(packet::unzigzag(value));
+                        emit(pc, out);
+                        break;
+                }
+            }
+        }
+
+        // Delta format starting at an arbitrary offset (e.g. the oldest data of a wrapped circular buffer):
+        // bytes before the first SYNC packet are skipped. Returns the number of bytes skipped.
+        std::size_t decodeDeltaFromSync(const std::uint8_t* data, std::size_t size, std::vector<DecodedInstruction>& out) const {
+            const std::size_t start = packet::findSync(data, size, 0);
+            if (start == packet::NO_SYNC) return size;
+            decodeDelta(data + start, size - start, out);
+            return start;
+        }
+
+        // Offsets of all SYNC packets; the segments between them decode independently
+        static std::vector<std::size_t> syncOffsets(const std::uint8_t* data, std::size_t size) {
+            std::vector<std::size_t> offsets;
+            for (std::size_t pos = packet::findSync(data, size, 0); pos != packet::NO_SYNC;
+                 pos = packet::findSync(data, size, pos + packet::SYNC_BYTES)) {
+                offsets.push_back(pos);
+            }
+            return offsets;
+        }
+
+        // Split a source-tagged funnel stream (packet::frame) into one byte stream per source ID;
+        // each stream then decodes with decodeRaw/decodeDelta
+        static std::map<std::uint32_t, std::vector<std::uint8_t>> splitSources(const std::uint8_t* data, std::size_t size) {
+            std::map<std::uint32_t, std::vector<std::uint8_t>> streams;
+            std::size_t pos = 0;
+            while (pos + packet::frame::HEADER_BYTES <= size) {
+                const std::uint32_t header = load_u32_le(data + pos);
+                if (!packet::frame::isHeader(header)) throw std::runtime_error("TraceDecoder: bad frame header");
+                const std::size_t length = packet::frame::length(header);
+                pos += packet::frame::HEADER_BYTES;
+                if (pos + length > size) throw std::runtime_error("TraceDecoder: truncated frame");
+                auto& stream = streams[packet::frame::sourceId(header)];
+                stream.insert(stream.end(), data + pos, data + pos + length);
+                pos += length;
+            }
+            return streams;
+        }
+
+        // Parallel decode of a large capture. Delta streams are split at SYNC packets (the sync scan
+        // itself runs in parallel), segments are grouped into chunks of about minChunkBytes and decoded
+        // on the pool; results are concatenated in stream order. With fromStreamStart = false
+        // (e.g. a wrapped circular buffer) bytes before the first SYNC are skipped. Raw streams are
+        // split on 8-byte record boundaries and keep the opcodes they carry, as decodeRaw does.
+        std::vector<DecodedInstruction> decodeParallel(const std::uint8_t* data, std::size_t size, Format format,
+                                                       ThreadPool& pool, bool fromStreamStart = true,
+                                                       std::size_t minChunkBytes = 1u << 20) const {
+            // Chunk boundaries [bounds[i], bounds[i + 1])
+            std::vector<std::size_t> bounds;
+            const std::size_t target = std::max(minChunkBytes, size / (pool.size() * 4) + 1);
+            if (format == Format::Raw) {
+                const std::size_t chunk = (target + 7) & ~static_cast<std::size_t>(7);
+                for (std::size_t pos = 0; pos < size; pos += chunk) bounds.push_back(pos);
+            } else {
+                const auto syncs = parallelSyncOffsets(data, size, pool);
+                if (fromStreamStart && (syncs.empty() || syncs[0] != 0)) bounds.push_back(0);
+                for (std::size_t sync : syncs) {
+                    if (bounds.empty() || sync - bounds.back() >= target) bounds.push_back(sync);
+                }
+            }
+            if (bounds.empty()) return {};
+            bounds.push_back(size);
+
+            std::vector<std::future<std::vector<DecodedInstruction>>> parts;
+            parts.reserve(bounds.size() - 1);
+            for (std::size_t i = 0; i + 1 < bounds.size(); ++i) {
+                const std::uint8_t* chunk = data + bounds[i];
+                const std::size_t chunkSize = bounds[i + 1] - bounds[i];
+                parts.push_back(pool.submit([this, chunk, chunkSize, format] {
+                    std::vector<DecodedInstruction> part;
+                    if (format == Format::Raw) {
+                        decodeRaw(chunk, chunkSize, part); // records carry their opcodes: no lookup
+                    } else {
+                        decodeDelta(chunk, chunkSize, part);
+                    }
+                    return part;
+                }));
+            }
+
+            std::vector<std::vector<DecodedInstruction>> decoded;
+            decoded.reserve(parts.size());
+            std::size_t total = 0;
+            for (auto& part : parts) {
+                decoded.push_back(part.get()); // rethrows decode errors
+                total += decoded.back().size();
+            }
+
+            // Ordered merge, copies run in parallel
+            std::vector<DecodedInstruction> out(total);
+            std::vector<std::future<void>> copies;
+            std::size_t offset = 0;
+            for (const auto& part : decoded) {
+                DecodedInstruction* dst = out.data() + offset;
+                copies.push_back(pool.submit([&part, dst] {
+                    if (!part.empty()) std::memcpy(dst, part.data(), part.size() * sizeof(DecodedInstruction));
+                }));
+                offset += part.size();
+            }
+            for (auto& copy : copies) copy.get();
+            return out;
+        }
+
+        // Capture file (e.g. written by TraceStreamSink), mapped read-only without copying
+        std::vector<DecodedInstruction> decodeFile(const std::string& path, Format format, ThreadPool& pool,
+                                                   bool fromStreamStart = true) const {
+            MappedFileMemory capture{path};
+            return decodeParallel(capture.data(), static_cast<std::size_t>(capture.size()), format, pool, fromStreamStart);
+        }
+
+        // SYNC offsets found by scanning slices in parallel (same result as syncOffsets)
+        static std::vector<std::size_t> parallelSyncOffsets(const std::uint8_t* data, std::size_t size, ThreadPool& pool) {
+            const std::size_t slices = pool.size();
+            const std::size_t slice = size / slices + 1;
+            std::vector<std::future<std::vector<std::size_t>>> found;
+            for (std::size_t begin = 0; begin < size; begin += slice) {
+                const std::size_t end = std::min(size, begin + slice);
+                found.push_back(pool.submit([data, size, begin, end] {
+                    // A marker starting before `end` may finish up to SYNC_MARKER_BYTES - 1 bytes later
+                    const std::size_t scanEnd = std::min(size, end + packet::SYNC_MARKER_BYTES - 1);
+                    std::vector<std::size_t> offsets;
+                    for (std::size_t pos = packet::findSync(data, scanEnd, begin); pos != packet::NO_SYNC && pos < end;
+                         pos = packet::findSync(data, scanEnd, pos + packet::SYNC_MARKER_BYTES)) {
+                        offsets.push_back(pos);
+                    }
+                    return offsets;
+                }));
+            }
+            std::vector<std::size_t> offsets;
+            for (auto& f : found) {
+                const auto part = f.get();
+                offsets.insert(offsets.end(), part.begin(), part.end());
+            }
+            return offsets;
+        }
+
+        // Convenience overloads for words fetched from TR_RAM_DATA (little-endian byte order)
+        static void decodeRaw(const std::vector<std::uint32_t>& words, std::vector<DecodedInstruction>& out) {
+            const std::size_t n = words.size() / 2;
+            out.reserve(out.size() + n);
+            for (std::size_t i = 0; i < n; ++i) {
+                out.push_back({words[2 * i], words[2 * i + 1]});
+            }
+        }
+
+        // Raw format into separate pc/opcode arrays (SIMD deinterleave), e.g. for fetch()/fetchBulk() output
+        static void decodeRaw(const std::uint32_t* words, std::size_t wordCount,
+                              std::vector<std::uint32_t>& pcs, std::vector<std::uint32_t>& opcodes) {
+            const std::size_t n = wordCount / 2;
+            const std::size_t base = pcs.size();
+            pcs.resize(base + n);
+            opcodes.resize(base + n);
+            simd::unpackRaw(words, n, pcs.data() + base, opcodes.data() + base);
+        }
+        void decodeDelta(const std::vector<std::uint32_t>& words, std::vector<DecodedInstruction>& out) const {
+            const auto bytes = toBytes(words);
+            decodeDelta(bytes.data(), bytes.size(), out);
+        }
+
+    private:
+        void emit(std::uint32_t pc, std::vector<DecodedInstruction>& out) const {
+            out.push_back({pc, lookup_ ? lookup_(pc) : 0u});
+        }
+
+        static std::uint32_t load_u32_le(const std::uint8_t* p) {
+            return static_cast<std::uint32_t>(p[0]) | (static_cast<std::uint32_t>(p[1]) << 8) |
+                   (static_cast<std::uint32_t>(p[2]) << 16) | (static_cast<std::uint32_t>(p[3]) << 24);
+        }
+
+        static std::vector<std::uint8_t> toBytes(const std::vector<std::uint32_t>& words) {
+            std::vector<std::uint8_t> bytes(words.size() * 4);
+            for (std::size_t i = 0; i < words.size(); ++i) {
+                bytes[4 * i]     = static_cast<std::uint8_t>(words[i]);
+                bytes[4 * i + 1] = static_cast<std::uint8_t>(words[i] >> 8);
+                bytes[4 * i + 2] = static_cast<std::uint8_t>(words[i] >> 16);
+                bytes[4 * i + 3] = static_cast<std::uint8_t>(words[i] >> 24);
+            }
+            return bytes;
+        }
+
+        OpcodeLookup lookup_;
+    };
+}
@@ -1,160 +1,299 @@
-#pragma once
-
-#include <iostream>
-#include <vector>
-#include <cstdint>
-
-#include "TraceBytesConnect.h"
-#include "IMmioDevice.h"
-#include "TraceControlRegisters.h"
-
-
-namespace tci {
-    class TraceEncoder : public IMmioDevice{
-    public:
-    TraceEncoder() {
-        // std::cout << "[TraceEncoder] constructor called" << std::endl;
-    }
-
-    ~TraceEncoder() {
-        // std::cout << "[TraceEncoder] destructor called" << std::endl;
-    }
-    
-    void connect(TraceBytesConnect* connector) {
-        out_ = connector;
-    }
-    
-    void emitTrace(std::uint32_t pc, std::uint32_t opcode) {
-        const bool active = (trTeControl_ & tci::tr_te::TR_TE_ACTIVE) != 0;
-        const bool enable = (trTeControl_ & tci::tr_te::TR_TE_ENABLE) != 0;
-        const bool tracing = (trTeControl_ & tci::tr_te::TR_TE_INST_TRACING) != 0;
-        
-        if(!active || !enable || !tracing) {
-            std::cout << "[TraceEncoder::emitTrace] Trace encoding is inactive or disabled or not tracing, skipping instruction emission" << std::endl;
-            return;
-        }
-    
-        if (!out_) {
-            std::cout << "[TraceEncoder::emitTrace] No out_ set" << std::endl;
-            return;
-        }
-        
-        TraceBytes buffer; // using TraceBytes = std::vector<std::uint8_t>;
-        buffer.reserve(8); // reserve space for 2 uint32_t
-        append_u32_le(buffer, pc); // pc
-        append_u32_le(buffer, opcode); // opcode
-
-        // std::cout << "[TraceEncoder::emitTrace] buffer filled with pc and opcode" << std::endl;
-        
-        out_->pushBytes(buffer);
-
-        // Status: once we emit something, it is not empty anymore
-        trTeControl_ &= ~tci::tr_te::TR_TE_EMPTY;
-    }
-    
-    std::uint32_t read32(std::uint32_t offset) override {
-        switch (offset) {
-            case tci::tr_te::TR_TE_CONTROL:
-                return trTeControl_;
-            default:
-                std::cout << "[TraceEncoder::read32] Invalid offset: " << std::hex << offset << std::dec << std::endl;
-            return 0;
-        }
-    }
-    
-    void write32(uint32_t offset, uint32_t value) override {
-        switch (offset) {
-            case tci::tr_te::TR_TE_CONTROL:{
-                const std::uint32_t oldValue = trTeControl_;
-
-                // Active bit = 0 (reset); 
-                // Active bit = 1 (release reset)
-                const bool newActive = (value & tci::tr_te::TR_TE_ACTIVE) != 0;
-                if(!newActive) {
-                    trTeControl_ = 0; // reset all control bits to default values when deactivating
-                    trTeControl_ |= tci::tr_te::TR_TE_EMPTY;
-                    std::cout << "[TraceEncoder::write32] TraceEncoder deactivated, internal state reset, control bits cleared" << std::endl;
-                    return;
-                }
-
-                // Normal masked write 
-                // Keep RO bits(EMPTY) as oldValue
-                const std::uint32_t keep_ro = oldValue & tci::tr_te::TR_TE_CONTROL_RO_MASK;
-                
-                // Take RW bits(ACTIVE, ENABLE, INST_TRACING, FORMAT) from new value
-                std::uint32_t new_rw  = value & tci::tr_te::TR_TE_CONTROL_RW_MASK;
-
-                // multi-bit fields write
-                new_rw = normalize_warl_fields(new_rw);
-
-                // register value updated (keep old + update only new)
-                trTeControl_ = keep_ro | new_rw;
-
-                // 3) RW1C behavior: trTeInstStallOrOverflow clears when software writes 1
-                if (value & tci::tr_te::TR_TE_INST_STALL_OR_OVERFLOW) {
-                    trTeControl_ &= ~tci::tr_te::TR_TE_INST_STALL_OR_OVERFLOW;
-                }
-
-                // 4) If Enable is cleared, it’s reasonable to mark "not tracing" in status
-                // if ((trTeControl_ & tci::tr_te::TR_TE_ENABLE) == 0) {
-                //     trTeControl_ &= ~tci::tr_te::TR_TE_INST_TRACING;
-                // }
-
-                // 5) If Active is set (released reset), Empty should usually be 1 until data is emitted
-                // if (newActive && !(trTeControl_ & tci::tr_te::TR_TE_INST_TRACING)) {
-                //     trTeControl_ |= tci::tr_te::TR_TE_EMPTY;
-                // }
-
-                break;
-            }
-            default:
-                std::cout << "[TraceEncoder::write32] Invalid offset: " << offset << std::endl;
-        }
-    }
-    
-    private:
-    static void append_u32_le(std::vector<uint8_t>& buffer, uint32_t value) {
-        buffer.push_back(static_cast<std::uint8_t>(value & 0xFF));
-        buffer.push_back(static_cast<std::uint8_t>((value >> 8) & 0xFF));
-        buffer.push_back(static_cast<std::uint8_t>((value >> 16) & 0xFF));
-        buffer.push_back(static_cast<std::uint8_t>((value >> 24) & 0xFF));
-    }
-
-    static std::uint32_t normalize_warl_fields(std::uint32_t rw_value) {
-        // WARL-lite: clamp fields to legal bitwidth and (optionally) supported subset.
-
-        auto clampField = [&](std::uint32_t mask, std::uint32_t shift, std::uint32_t max_val) {
-            std::uint32_t v = (rw_value & mask) >> shift;
-            if (v > max_val) v = max_val; // clamp
-            rw_value = (rw_value & ~mask) | ((v << shift) & mask);
-        };
-
-        // InstMode is 3 bits [6:4] -> legal 0..7
-        clampField(tci::tr_te::TR_TE_INST_MODE_MASK,
-                    tci::tr_te::TR_TE_INST_MODE_SHIFT,
-                    7u);
-
-        // InstSyncMode is 2 bits [17:16] -> legal 0..3
-        clampField(tci::tr_te::TR_TE_INST_SYNC_MODE_MASK,
-                    tci::tr_te::TR_TE_INST_SYNC_MODE_SHIFT,
-                    3u);
-
-        // InstSyncMax is 4 bits [23:20] -> legal 0..15
-        clampField(tci::tr_te::TR_TE_INST_SYNC_MAX_MASK,
-                    tci::tr_te::TR_TE_INST_SYNC_MAX_SHIFT,
-                    15u);
-
-        // Format is 3 bits [26:24] -> legal 0..7
-        clampField(tci::tr_te::TR_TE_FORMAT_MASK,
-                    tci::tr_te::TR_TE_FORMAT_SHIFT,
-                    7u);
-
-        return rw_value;
-    }
-
-    private:
-    TraceBytesConnect* out_ = nullptr;
-    std::uint32_t trTeControl_ = 0; // enable = 0 (default)
-        
-    };
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+#include <cstring>
+
+#include "TraceBytesConnect.h"
+#include "IMmioDevice.h"
+#include "TraceControlRegisters.h"
+#include "TraceLog.h"
+#include "TracePacket.h"
+#include "RawPackKernels.h"
+
+
+namespace tci {
+    class TraceEncoder : public IMmioDevice{
+    public:
+    TraceEncoder() {
+        // std::cout << "[TraceEncoder] constructor called" << std::endl;
+    }
+
+    ~TraceEncoder() {
+        // std::cout << "[TraceEncoder] destructor called" << std::endl;
+    }
+    
+    void connect(TraceBytesConnect* connector) {
+        out_ = connector;
+    }
+    
+    void emitTrace(std::uint32_t pc, std::uint32_t opcode) {
+        const bool active = (trTeControl_ & tci::tr_te::TR_TE_ACTIVE) != 0;
+        const bool enable = (trTeControl_ & tci::tr_te::TR_TE_ENABLE) != 0;
+        const bool tracing = (trTeControl_ & tci::tr_te::TR_TE_INST_TRACING) != 0;
+        
+        if(!active || !enable || !tracing) {
+            ++skippedDisabled_;
+            TCI_LOG_DEBUG("[TraceEncoder::emitTrace] Trace encoding is inactive or disabled or not tracing, skipping instruction emission");
+            return;
+        }
+    
+        if (!out_) {
+            ++skippedNoOutput_;
+            TCI_LOG_DEBUG("[TraceEncoder::emitTrace] No out_ set");
+            return;
+        }
+
+        if (isDeltaFormat()) {
+            encodeDelta(pc);
+            return;
+        }
+        
+        std::uint8_t buffer[RECORD_BYTES]; // stack buffer, no per-instruction allocation
+        store_u32_le(buffer, pc); // pc
+        store_u32_le(buffer + 4, opcode); // opcode
+
+        // std::cout << "[TraceEncoder::emitTrace] buffer filled with pc and opcode" << std::endl;
+        
+        if (!push(buffer, RECORD_BYTES)) {
+            trTeControl_ |= tci::tr_te::TR_TE_INST_STALL_OR_OVERFLOW; // downstream buffer/queue full: data dropped
+        }
+
+        // Status: once we emit something, it is not empty anymore
+        trTeControl_ &= ~tci::tr_te::TR_TE_EMPTY;
+    }
+
+    // Batched emit: control bits are checked once per batch, records are encoded into a
+    // stack chunk and pushed downstream as one contiguous block per chunk.
+    void emitTraceBatch(const std::uint32_t* pcs, const std::uint32_t* opcodes, std::size_t n) {
+        const bool active = (trTeControl_ & tci::tr_te::TR_TE_ACTIVE) != 0;
+        const bool enable = (trTeControl_ & tci::tr_te::TR_TE_ENABLE) != 0;
+        const bool tracing = (trTeControl_ & tci::tr_te::TR_TE_INST_TRACING) != 0;
+
+        if(!active || !enable || !tracing) {
+            skippedDisabled_ += n;
+            TCI_LOG_DEBUG("[TraceEncoder::emitTraceBatch] Trace encoding is inactive or disabled or not tracing, skipping batch emission");
+            return;
+        }
+
+        if (!out_) {
+            skippedNoOutput_ += n;
+            TCI_LOG_DEBUG("[TraceEncoder::emitTraceBatch] No out_ set");
+            return;
+        }
+        if (n == 0) return;
+
+        if (isDeltaFormat()) {
+            for (std::size_t i = 0; i < n; ++i) encodeDelta(pcs[i]);
+            return;
+        }
+
+        std::uint8_t chunk[BATCH_CHUNK_BYTES];
+        std::size_t i = 0;
+        while (i < n) {
+            const std::size_t records = std::min(n - i, BATCH_CHUNK_RECORDS);
+            simd::packRaw(pcs + i, opcodes + i, records, chunk); // SSE2/AVX2 interleave when available
+            if (!push(chunk, records * RECORD_BYTES)) {
+                trTeControl_ |= tci::tr_te::TR_TE_INST_STALL_OR_OVERFLOW; // downstream buffer/queue full: data dropped
+            }
+            i += records;
+        }
+
+        trTeControl_ &= ~tci::tr_te::TR_TE_EMPTY;
+    }
+    
+    std::uint32_t read32(std::uint32_t offset) override {
+        switch (offset) {
+            case tci::tr_te::TR_TE_CONTROL:
+                return trTeControl_;
+            default:
+                TCI_LOG_WARN("[TraceEncoder::read32] Invalid offset: " << std::hex << offset << std::dec);
+            return 0;
+        }
+    }
+    
+    void write32(uint32_t offset, uint32_t value) override {
+        switch (offset) {
+            case tci::tr_te::TR_TE_CONTROL:{
+                // Active bit = 0 (reset); 
+                // Active bit = 1 (release reset)
+                const bool newActive = (value & tci::tr_te::TR_TE_ACTIVE) != 0;
+
+                // Delta format: pending run/packets go out when tracing stops or the format changes
+                const std::uint32_t streamBits = tci::tr_te::TR_TE_ENABLE | tci::tr_te::TR_TE_INST_TRACING | tci::tr_te::TR_TE_FORMAT_MASK;
+                if (newActive && (value & streamBits) != (trTeControl_ & streamBits)) {
+                    flush();
+                }
+
+                const std::uint32_t oldValue = trTeControl_;
+                if(!newActive) {
+                    trTeControl_ = 0; // reset all control bits to default values when deactivating
+                    trTeControl_ |= tci::tr_te::TR_TE_EMPTY;
+                    resetDeltaState(); // pending delta data is discarded
+                    TCI_LOG_INFO("[TraceEncoder::write32] TraceEncoder deactivated, internal state reset, control bits cleared");
+                    return;
+                }
+
+                // Normal masked write (TR_TE_CONTROL_REG): RO bits(EMPTY) and RW1C status bits(STALL_OR_OVERFLOW)
+                // keep oldValue, RW bits(ACTIVE, ENABLE, INST_TRACING, FORMAT, ...) come WARL-normalized from value,
+                // and trTeInstStallOrOverflow clears when software writes 1
+                trTeControl_ = tci::tr_te::TR_TE_CONTROL_REG.applyWrite(oldValue, value);
+
+                // 4) If Enable is cleared, it’s reasonable to mark "not tracing" in status
+                // if ((trTeControl_ & tci::tr_te::TR_TE_ENABLE) == 0) {
+                //     trTeControl_ &= ~tci::tr_te::TR_TE_INST_TRACING;
+                // }
+
+                // 5) If Active is set (released reset), Empty should usually be 1 until data is emitted
+                // if (newActive && !(trTeControl_ & tci::tr_te::TR_TE_INST_TRACING)) {
+                //     trTeControl_ |= tci::tr_te::TR_TE_EMPTY;
+                // }
+
+                break;
+            }
+            default:
+                TCI_LOG_WARN("[TraceEncoder::write32] Invalid offset: " << offset);
+        }
+    }
+    
+    // Delta format: push the pending run and packets downstream, padded to a 4-byte boundary.
+    // Called automatically when tracing is disabled or the format changes. The next
+    // instruction starts with an ADDRESS packet.
+    void flush() {
+        if (!out_ || (!haveAddress_ && pendingLen_ == 0)) return;
+        flushRun();
+        while ((streamBytes_ + pendingLen_) & 0x3u) pending_[pendingLen_++] = packet::TYPE_PAD;
+        pushPending();
+        haveAddress_ = false;
+        syncCounter_ = 0; // next instruction starts with an ADDRESS anyway
+        syncDue_ = false;
+        trTeControl_ |= tci::tr_te::TR_TE_EMPTY; // nothing held in the encoder
+    }
+
+    // Diagnostic counters: instructions not encoded because tracing was off / nothing was connected
+    std::uint64_t skippedDisabled() const { return skippedDisabled_; }
+    std::uint64_t skippedNoOutput() const { return skippedNoOutput_; }
+
+    static constexpr std::size_t RECORD_BYTES = 8; // raw format: pc + opcode, little-endian
+    static constexpr std::size_t BATCH_CHUNK_RECORDS = 512;
+    static constexpr std::size_t BATCH_CHUNK_BYTES = BATCH_CHUNK_RECORDS * RECORD_BYTES; // 4 KB
+    static constexpr std::size_t DELTA_PENDING_BYTES = 256; // delta packets staged before pushBytes
+
+    private:
+    // trTeInstStallEna: stall (wait for room downstream) instead of overflowing
+    bool push(const std::uint8_t* data, std::size_t n) {
+        if (trTeControl_ & tci::tr_te::TR_TE_INST_STALL_ENA) return out_->pushBytesStalling(data, n);
+        return out_->pushBytes(data, n);
+    }
+
+    bool isDeltaFormat() const {
+        return tci::tr_te::TR_TE_FORMAT_FIELD.get(trTeControl_) == tci::tr_te::TR_TE_FORMAT_DELTA;
+    }
+
+    // Sequential pcs extend the current run; anything else ends it and emits a DELTA packet.
+    // Every 2^(trTeInstSyncMax + 4) units (see syncUnits) the instruction is sent as a SYNC packet instead.
+    void encodeDelta(std::uint32_t pc) {
+        const std::size_t startLen = pendingLen_;
+        if (!haveAddress_ && syncMode() != 0) syncDue_ = true; // stream (re)starts at a seekable point
+        if (syncDue_) {
+            flushRun();
+            std::memcpy(pending_ + pendingLen_, packet::SYNC_MARKER, packet::SYNC_MARKER_BYTES);
+            store_u32_le(pending_ + pendingLen_ + packet::SYNC_MARKER_BYTES, pc);
+            pendingLen_ += packet::SYNC_BYTES;
+            haveAddress_ = true;
+            syncDue_ = false;
+            syncCounter_ = 0;
+        } else if (!haveAddress_) {
+            pending_[pendingLen_++] = packet::TYPE_ADDRESS;
+            store_u32_le(pending_ + pendingLen_, pc);
+            pendingLen_ += 4;
+            haveAddress_ = true;
+        } else {
+            const std::uint32_t expected = lastPc_ + packet::INST_BYTES;
+            if (pc == expected && run_ < MAX_RUN) {
+                ++run_;
+                lastPc_ = pc;
+                trTeControl_ &= ~tci::tr_te::TR_TE_EMPTY;
+                countSync(0); // no bytes yet (the RUN packet counts when flushed), but one instruction
+                return;
+            }
+            flushRun();
+            if (pc == expected) {
+                run_ = 1; // run limit reached: start a new run
+            } else {
+                pendingLen_ += packet::put(pending_ + pendingLen_, packet::TYPE_DELTA,
+                                           packet::zigzag(static_cast<std::int32_t>(pc - expected)));
+            }
+        }
+        lastPc_ = pc;
+        trTeControl_ &= ~tci::tr_te::TR_TE_EMPTY;
+        countSync(pendingLen_ - startLen);
+        if (pendingLen_ > DELTA_PENDING_BYTES - packet::MAX_PACKET_BYTES - packet::SYNC_BYTES) pushPending();
+    }
+
+    // trTeInstSyncMode: 0 = off, 1 = trace bytes, 2 = instructions, 3 = instruction halfwords
+    std::uint32_t syncMode() const {
+        return tci::tr_te::TR_TE_INST_SYNC_MODE_FIELD.get(trTeControl_);
+    }
+
+    void countSync(std::size_t packetBytes) {
+        const std::uint32_t mode = syncMode();
+        if (mode == 0) return;
+        syncCounter_ += (mode == 1) ? static_cast<std::uint32_t>(packetBytes) : (mode == 2) ? 1u : packet::INST_BYTES / 2;
+        const std::uint32_t syncMax = tci::tr_te::TR_TE_INST_SYNC_MAX_FIELD.get(trTeControl_);
+        if (syncCounter_ >= (1u << (syncMax + 4))) syncDue_ = true;
+    }
+
+    void flushRun() {
+        if (run_ == 0) return;
+        pendingLen_ += packet::put(pending_ + pendingLen_, packet::TYPE_RUN, run_);
+        run_ = 0;
+    }
+
+    void pushPending() {
+        if (pendingLen_ == 0) return;
+        if (!push(pending_, pendingLen_)) {
+            trTeControl_ |= tci::tr_te::TR_TE_INST_STALL_OR_OVERFLOW; // downstream buffer/queue full: data dropped
+        }
+        streamBytes_ += pendingLen_;
+        pendingLen_ = 0;
+    }
+
+    void resetDeltaState() {
+        pendingLen_ = 0;
+        run_ = 0;
+        haveAddress_ = false;
+        streamBytes_ = 0;
+        syncCounter_ = 0;
+        syncDue_ = false;
+    }
+
+    static void store_u32_le(std::uint8_t* dst, std::uint32_t value) {
+        dst[0] = static_cast<std::uint8_t>(value & 0xFF);
+        dst[1] = static_cast<std::uint8_t>((value >> 8) & 0xFF);
+        dst[2] = static_cast<std::uint8_t>((value >> 16) & 0xFF);
+        dst[3] = static_cast<std::uint8_t>((value >> 24) & 0xFF);
+    }
+
+    private:
+    TraceBytesConnect* out_ = nullptr;
+    std::uint32_t trTeControl_ = 0; // enable = 0 (default)
+    std::uint64_t skippedDisabled_ = 0;
+    std::uint64_t skippedNoOutput_ = 0;
+
+    // Delta format state
+    static constexpr std::uint32_t MAX_RUN = 0x7FFFFFFFu;
+    std::uint8_t pending_[DELTA_PENDING_BYTES];
+    std::size_t pendingLen_ = 0;
+    std::uint64_t streamBytes_ = 0; // bytes pushed so far, for 4-byte alignment on flush
+    std::uint32_t lastPc_ = 0;
+    std::uint32_t run_ = 0;
+    bool haveAddress_ = false;
+    std::uint32_t syncCounter_ = 0; // units since the last ADDRESS/SYNC
+    bool syncDue_ = false;
+        
+    };
 }
\ No newline at end of file
@@ -0,0 +1,129 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <chrono>
+#include <memory>
+#include <vector>
+#include <algorithm>
+
+#include "TraceSystem.h"
+#include "TraceControllerInterface.h"
+#include "ProbeHwAccess.h"
+#include "ThreadPool.h"
+
+namespace tci {
+    // Owns N TraceSystem + TraceControllerInterface pairs and runs their workloads on a WorkStealingPool.
+    // A system's work is a chain of chunk tasks (emit a chunk, drain the sink into the system's output),
+    // each submitting the next, so a system is touched by one task at a time and systems share no locks.
+    // Workers that run out of chunks steal other systems' next chunks.
+    class TraceFarm {
+    public:
+        struct Result {
+            std::uint64_t instructions = 0; // emitted, all systems
+            std::uint64_t words = 0;        // captured into the outputs, all systems
+            double seconds = 0.0;
+        };
+
+        TraceFarm(std::size_t systems, std::uint32_t sinkBytes, std::size_t threads = 0)
+            : sinkBytes_(sinkBytes), pool_(threads) {
+            nodes_.reserve(systems);
+            for (std::size_t i = 0; i < systems; ++i) nodes_.push_back(std::make_unique<Node>(sinkBytes, i));
+        }
+
+        TraceFarm(const TraceFarm&) = delete;
+        TraceFarm& operator=(const TraceFarm&) = delete;
+
+        std::size_t size() const { return nodes_.size(); }
+        std::size_t threadCount() const { return pool_.size(); }
+        std::uint64_t steals() const { return pool_.steals(); }
+
+        // Per-system access, e.g. to change the trace format before run()
+        TraceSystem& system(std::size_t i) { return nodes_.at(i)->sys; }
+        TraceControllerInterface& controller(std::size_t i) { return nodes_.at(i)->tci; }
+
+        // Trace words captured from system i by the last run()
+        const std::vector<std::uint32_t>& output(std::size_t i) const { return nodes_.at(i)->output; }
+
+        // Every system: configure + start, emit `instructions` synthetic instructions (pc = 0x80000000 + 4k,
+        // opcode = system index ^ k) in chunks, draining its sink into output(i) after each chunk, then
+        // stop + final drain. Chunks are capped to what the sink holds in raw format, so nothing is dropped.
+        Result run(std::size_t instructions, std::size_t chunk = 4096) {
+            const std::size_t perChunk = std::max<std::size_t>(1, std::min<std::size_t>(chunk, sinkBytes_ / 8));
+            for (auto& node : nodes_) {
+                node->emitted = 0;
+                node->captured = 0;
+                node->pcs.resize(perChunk);
+                node->opcodes.resize(perChunk);
+                node->output.resize(2 * instructions);
+            }
+
+            const auto t0 = std::chrono::steady_clock::now();
+            for (auto& node : nodes_) {
+                Node* n = node.get();
+                pool_.submit([this, n, instructions, perChunk] { runChunk(*n, instructions, perChunk); });
+            }
+            pool_.wait();
+            const auto t1 = std::chrono::steady_clock::now();
+
+            Result result;
+            result.seconds = std::chrono::duration<double>(t1 - t0).count();
+            for (const auto& node : nodes_) {
+                result.instructions += node->emitted;
+                result.words += node->captured;
+            }
+            return result;
+        }
+
+    private:
+        // One system and its workload state; only the task running its current chunk touches it
+        struct Node {
+            Node(std::uint32_t sinkBytes, std::size_t i)
+                : index(static_cast<std::uint32_t>(i)), sys(sinkBytes), probe(sys.mmioBus, {}, ProbeHwAccess::LogMode::Off),
+                  tci(probe, TraceSystem::TR_TE_BASE, TraceSystem::TR_FUNNEL_BASE, TraceSystem::TR_RAM_SINK_BASE) {
+                tci.setVerifyPolicy(TraceControllerInterface::VerifyPolicy::OnConfigure);
+            }
+
+            std::uint32_t index;
+            TraceSystem sys;
+            ProbeHwAccess probe;
+            TraceControllerInterface tci;
+            std::vector<std::uint32_t> pcs;
+            std::vector<std::uint32_t> opcodes;
+            std::vector<std::uint32_t> output;
+            std::size_t emitted = 0;
+            std::size_t captured = 0;
+        };
+
+        void runChunk(Node& node, std::size_t instructions, std::size_t perChunk) {
+            if (node.emitted == 0) {
+                node.tci.configure();
+                node.tci.start();
+            }
+            const std::size_t n = std::min(perChunk, instructions - node.emitted);
+            for (std::size_t k = 0; k < n; ++k) {
+                const auto pos = static_cast<std::uint32_t>(node.emitted + k);
+                node.pcs[k] = 0x80000000u + 4 * pos;
+                node.opcodes[k] = node.index ^ pos;
+            }
+            if (n != 0) node.sys.emitTraceBatch(node.pcs.data(), node.opcodes.data(), n);
+            node.emitted += n;
+            drain(node);
+
+            if (node.emitted < instructions) {
+                pool_.submit([this, &node, instructions, perChunk] { runChunk(node, instructions, perChunk); });
+                return;
+            }
+            node.tci.stop();
+            drain(node);
+            node.output.resize(node.captured);
+        }
+
+        static void drain(Node& node) {
+            node.captured += node.tci.fetchBulk(node.output.data() + node.captured, node.output.size() - node.captured);
+        }
+
+        std::uint32_t sinkBytes_;
+        std::vector<std::unique_ptr<Node>> nodes_;
+        WorkStealingPool pool_; // declared last: its workers stop before the systems go away
+    };
+}
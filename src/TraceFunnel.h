@@ -1,121 +1,413 @@
-#pragma once
-
-#include <iostream>
-#include <cstdint>
-#include <cstddef>
-
-#include "TraceBytesConnect.h"
-#include "IMmioDevice.h"
-#include "TraceControlRegisters.h"
-
-
-namespace tci {
-    class TraceFunnel : public TraceBytesConnect, public IMmioDevice {
-        public:
-        TraceFunnel() {
-            // std::cout << "[TraceFunnel] constructor called" << std::endl;
-        }
-        
-        ~TraceFunnel() {
-            // std::cout << "[TraceFunnel] destructor called" << std::endl;
-        }
-        
-        void connect(TraceBytesConnect* connector) {
-            out_ = connector;
-        }
-        
-        void pushBytes(const std::uint8_t* data, std::size_t length) override {
-            const bool active = (trFunnelControl_ & tci::tr_tf::TR_FUNNEL_ACTIVE) != 0;
-            const bool enable = (trFunnelControl_ & tci::tr_tf::TR_FUNNEL_ENABLE) != 0;
-            const bool disInput = (trFunnelDisInput_ & tci::tr_tf::TR_FUNNEL_DIS_INPUT_MASK) != 0;
-            
-            if(!active || !enable) {
-                std::cout << "[TraceFunnel::pushBytes] Trace funneling is disabled" << std::endl;
-                return;
-            }
-
-            if (out_) {
-                if(disInput) {
-                    std::cout << "[TraceFunnel::pushBytes] Trace funneling input is disabled" << std::endl;
-                    return;
-                }
-                // std::cout << "[TraceFunnel::pushBytes] Pushing bytes to connector" << std::endl;
-                out_->pushBytes(data, length);
-            } else {
-                std::cout << "[TraceFunnel::pushBytes] No out_ set" << std::endl;
-            }
-        }
-        
-        // void set_funnelControl(uint32_t control) {
-        //     trFunnelControl_ = control;
-        // }
-        
-        std::uint32_t read32(std::uint32_t offset) override {
-            switch (offset) {
-                case tci::tr_tf::TR_FUNNEL_CONTROL:
-                    return trFunnelControl_;
-                case tci::tr_tf::TR_FUNNEL_DIS_INPUT:
-                    return trFunnelDisInput_;
-                default:
-                    std::cout << "[TraceFunnel::read32] Invalid offset: " << offset << std::endl;
-                return 0;
-            }
-        }
-        
-        void write32(std::uint32_t offset, std::uint32_t value) override {
-            switch (offset) {
-            case tci::tr_tf::TR_FUNNEL_CONTROL: {
-                const std::uint32_t oldValue = trFunnelControl_;
-
-                const bool newActive = (value & tci::tr_tf::TR_FUNNEL_ACTIVE) != 0;
-                if(!newActive) {
-                    trFunnelControl_ = 0; // reset all control bits to default values when deactivating
-                    std::cout << "[TraceFunnel::write32] TraceFunnel deactivated, internal state reset, control bits cleared" << std::endl;
-                    return;
-                }
-
-                // keep RO bits(EMPTY) as oldValue
-                const std::uint32_t keep_ro = oldValue & tci::tr_tf::TR_FUNNEL_CONTROL_RO_MASK;
-                // Normal masked write
-                // Take RW bits(ACTIVE, ENABLE) from new value
-                const std::uint32_t new_rw  = value & tci::tr_tf::TR_FUNNEL_CONTROL_RW_MASK;
-                trFunnelControl_ = keep_ro | new_rw;
-
-                break;
-            }
-            case tci::tr_tf::TR_FUNNEL_DIS_INPUT: {
-                // take RW bits from new value
-                const std::uint32_t new_rw  = value & tci::tr_tf::TR_FUNNEL_DIS_INPUT_RW_MASK;
-                trFunnelDisInput_ = normalizeWarlFields(new_rw);                
-                break;
-            }
-            default:
-                std::cout << "[TraceFunnel::write32] Invalid offset: " << offset << std::endl;
-            break;
-        }
-    }
-    
-    static std::uint32_t normalizeWarlFields(std::uint32_t rw_value) {
-        // WARL-lite: clamp fields to legal bitwidth and (optionally) supported subset.
-        
-        auto clamp_field = [&](std::uint32_t mask, std::uint32_t shift, std::uint32_t max_val) {
-            std::uint32_t v = (rw_value & mask) >> shift;
-            if (v > max_val) v = max_val; // clamp
-            rw_value = (rw_value & ~mask) | ((v << shift) & mask);
-        };
-        
-        // InstMode is 16 bits [15:0] -> legal 0..(2^16-1)
-        clamp_field(tci::tr_tf::TR_FUNNEL_DIS_INPUT_MASK,
-            0,
-            0xFFFFu);
-            
-        return rw_value;
-    }
-        
-    private:
-        TraceBytesConnect* out_ = nullptr;
-        
-        std::uint32_t trFunnelControl_ = 0; // enable = 0 (default)
-        std::uint32_t trFunnelDisInput_ = 0;
-    };
-}
+#pragma once
+
+#include <iostream>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <array>
+#include <vector>
+#include <stdexcept>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <chrono>
+
+#include "TraceBytesConnect.h"
+#include "TracePacket.h"
+#include "IMmioDevice.h"
+#include "TraceControlRegisters.h"
+#include "TraceLog.h"
+
+
+namespace tci {
+    class TraceFunnel : public TraceBytesConnect, public IMmioDevice {
+        public:
+        static constexpr std::size_t MAX_INPUTS = 16; // one TR_FUNNEL_DIS_INPUT bit per input
+
+        TraceFunnel() {
+            // std::cout << "[TraceFunnel] constructor called" << std::endl;
+            for (std::size_t i = 0; i < MAX_INPUTS; ++i) {
+                inputs_[i].funnel_ = this;
+                inputs_[i].index_ = static_cast<std::uint32_t>(i);
+            }
+        }
+        
+        ~TraceFunnel() {
+            // std::cout << "[TraceFunnel] destructor called" << std::endl;
+            stopMergeThread();
+        }
+
+        TraceFunnel(const TraceFunnel&) = delete;
+        TraceFunnel& operator=(const TraceFunnel&) = delete;
+        
+        void connect(TraceBytesConnect* connector) {
+            out_ = connector;
+        }
+
+        // Upstream connection point for input `index`; gated by TR_FUNNEL_DIS_INPUT[index]
+        TraceBytesConnect* input(std::size_t index) {
+            if (index >= MAX_INPUTS) throw std::out_of_range("TraceFunnel input index out of range");
+            return &inputs_[index];
+        }
+
+        // Wrap every push in a packet::frame header carrying sourceIdBase + input index,
+        // so the sink stream of several encoders can be split per source again
+        void setSourceTagging(bool enable) { sourceTagging_ = enable; }
+        bool sourceTagging() const { return sourceTagging_; }
+        void setSourceIdBase(std::uint32_t base) { sourceIdBase_ = base; }
+        std::uint32_t sourceIdBase() const { return sourceIdBase_; }
+
+        // Per-input queues for concurrent producers (one thread per encoder). Each input gets a lock-free
+        // single-producer/single-consumer byte ring; a merge stage (pump() or the merge thread) forwards
+        // whole pushes downstream, so producers never contend with each other or with the sink.
+        // Without queues every push goes straight downstream on the caller's thread.
+        enum class Backpressure {
+            Stall, // ring full: the producer runs merge rounds itself until its push fits
+            Drop   // ring full: drop the push, pushBytes returns false (overflow); pushBytesStalling still stalls
+        };
+        // The merge stage forwards with pushBytesStalling under Stall and for entries queued by
+        // pushBytesStalling, otherwise with pushBytes. A merged push the downstream rejects is counted
+        // (droppedDownstream) and the next push on its input returns false, so its encoder sets
+        // trTeInstStallOrOverflow.
+
+        static constexpr std::size_t MERGE_QUANTUM = 4096; // bytes per input and weight unit per merge round
+
+        // queueBytes is rounded up to a power of two. Call before producers start.
+        void enableInputQueues(std::size_t queueBytes = 1u << 16, Backpressure backpressure = Backpressure::Stall) {
+            std::size_t capacity = 64;
+            while (capacity < queueBytes) capacity <<= 1;
+            for (auto& in : inputs_) {
+                in.ring.assign(capacity, 0);
+                in.head.store(0, std::memory_order_relaxed);
+                in.tail.store(0, std::memory_order_relaxed);
+            }
+            queueMask_ = capacity - 1;
+            const std::size_t maxPayload = capacity / 2 - packet::frame::HEADER_BYTES;
+            maxFramePayload_ = (maxPayload < packet::frame::MAX_PAYLOAD) ? maxPayload : packet::frame::MAX_PAYLOAD;
+            backpressure_ = backpressure;
+            sticky_ = NO_INPUT;
+            queued_ = true;
+        }
+        bool inputQueuesEnabled() const { return queued_; }
+
+        // Weighted round-robin: input `index` forwards up to weight * MERGE_QUANTUM bytes per round (at least one push)
+        void setInputWeight(std::size_t index, std::uint32_t weight) {
+            if (index >= MAX_INPUTS) throw std::out_of_range("TraceFunnel input index out of range");
+            inputs_[index].weight = (weight != 0) ? weight : 1;
+        }
+
+        // One merge round over all inputs in index order; returns the queued bytes consumed
+        std::size_t pump() {
+            std::lock_guard<std::mutex> lock(mergeMutex_);
+            std::size_t total = 0;
+            if (sticky_ != NO_INPUT) { // finish a split push before serving other inputs
+                total += mergeInput(inputs_[sticky_]);
+                if (sticky_ != NO_INPUT) return total;
+            }
+            for (auto& in : inputs_) {
+                total += mergeInput(in);
+                if (sticky_ != NO_INPUT) break;
+            }
+            return total;
+        }
+
+        // Merge until every queue is empty
+        void drain() {
+            while (pump() != 0) {}
+        }
+
+        // Merge on a background thread; it sleeps for idleWait when all queues are empty
+        void startMergeThread(std::chrono::microseconds idleWait = std::chrono::microseconds(20)) {
+            if (!queued_) throw std::logic_error("TraceFunnel: enableInputQueues() before startMergeThread()");
+            if (merger_.joinable()) return;
+            merging_.store(true, std::memory_order_release);
+            merger_ = std::thread([this, idleWait] {
+                while (merging_.load(std::memory_order_acquire)) {
+                    if (pump() == 0) std::this_thread::sleep_for(idleWait);
+                }
+            });
+        }
+
+        // Join the merge thread, then forward whatever is still queued
+        void stopMergeThread() {
+            if (!merger_.joinable()) return;
+            merging_.store(false, std::memory_order_release);
+            merger_.join();
+            drain();
+        }
+        
+        // Direct pushes arrive on input 0
+        bool pushBytes(const std::uint8_t* data, std::size_t length) override {
+            return pushFrom(0, data, length);
+        }
+        bool pushBytesStalling(const std::uint8_t* data, std::size_t length) override {
+            return pushFrom(0, data, length, true);
+        }
+
+        // Pushes dropped because the funnel or the input is disabled are counted (droppedDisabled) and
+        // are not an overflow. stall: wait for queue room / ask the sink to stall, even in Drop mode.
+        bool pushFrom(std::uint32_t index, const std::uint8_t* data, std::size_t length, bool stall = false) {
+            const std::uint32_t control = trFunnelControl_.load(std::memory_order_relaxed);
+            const bool active = (control & tci::tr_tf::TR_FUNNEL_ACTIVE) != 0;
+            const bool enable = (control & tci::tr_tf::TR_FUNNEL_ENABLE) != 0;
+            const bool disInput = (trFunnelDisInput_.load(std::memory_order_relaxed) & (1u << index)) != 0;
+            
+            if(!active || !enable) {
+                droppedDisabled_.fetch_add(length, std::memory_order_relaxed);
+                TCI_LOG_DEBUG("[TraceFunnel::pushBytes] Trace funneling is disabled");
+                return true;
+            }
+
+            if (out_) {
+                if(disInput) {
+                    droppedDisabled_.fetch_add(length, std::memory_order_relaxed);
+                    TCI_LOG_DEBUG("[TraceFunnel::pushBytes] Trace funneling input " << index << " is disabled");
+                    return true;
+                }
+                // std::cout << "[TraceFunnel::pushBytes] Pushing bytes to connector" << std::endl;
+                if (queued_) return enqueue(inputs_[index], data, length, stall);
+                if (!sourceTagging_) return stall ? out_->pushBytesStalling(data, length) : out_->pushBytes(data, length);
+                return pushFramed(sourceIdBase_ + index, data, length, stall);
+            } else {
+                droppedNoOutput_.fetch_add(length, std::memory_order_relaxed);
+                TCI_LOG_DEBUG("[TraceFunnel::pushBytes] No out_ set");
+                return true;
+            }
+        }
+        
+        // Diagnostic counters: bytes dropped because the funnel/input was disabled / nothing was connected
+        std::uint64_t droppedDisabled() const { return droppedDisabled_.load(std::memory_order_relaxed); }
+        std::uint64_t droppedNoOutput() const { return droppedNoOutput_.load(std::memory_order_relaxed); }
+        // Bytes dropped because an input queue was full (Backpressure::Drop)
+        std::uint64_t droppedQueueFull() const { return droppedQueueFull_.load(std::memory_order_relaxed); }
+        // Bytes of merged pushes the downstream sink/funnel rejected (in full or in part)
+        std::uint64_t droppedDownstream() const { return droppedDownstream_.load(std::memory_order_relaxed); }
+
+        // void set_funnelControl(uint32_t control) {
+        //     trFunnelControl_ = control;
+        // }
+        
+        std::uint32_t read32(std::uint32_t offset) override {
+            switch (offset) {
+                case tci::tr_tf::TR_FUNNEL_CONTROL: {
+                    const std::uint32_t control = trFunnelControl_.load(std::memory_order_relaxed);
+                    if (!queued_) return control;
+                    // With input queues, trFunnelEmpty reports whether anything is still waiting to be merged
+                    return queuesEmpty() ? (control | tci::tr_tf::TR_FUNNEL_EMPTY) : (control & ~tci::tr_tf::TR_FUNNEL_EMPTY);
+                }
+                case tci::tr_tf::TR_FUNNEL_DIS_INPUT:
+                    return trFunnelDisInput_.load(std::memory_order_relaxed);
+                default:
+                    TCI_LOG_WARN("[TraceFunnel::read32] Invalid offset: " << offset);
+                return 0;
+            }
+        }
+        
+        void write32(std::uint32_t offset, std::uint32_t value) override {
+            switch (offset) {
+            case tci::tr_tf::TR_FUNNEL_CONTROL: {
+                const std::uint32_t oldValue = trFunnelControl_.load(std::memory_order_relaxed);
+
+                // Queued pushes were already accepted: forward them before the funnel stops
+                const std::uint32_t running = tci::tr_tf::TR_FUNNEL_ACTIVE | tci::tr_tf::TR_FUNNEL_ENABLE;
+                if (queued_ && (value & running) != running) drain();
+
+                const bool newActive = (value & tci::tr_tf::TR_FUNNEL_ACTIVE) != 0;
+                if(!newActive) {
+                    trFunnelControl_.store(0, std::memory_order_relaxed); // reset all control bits to default values when deactivating
+                    TCI_LOG_INFO("[TraceFunnel::write32] TraceFunnel deactivated, internal state reset, control bits cleared");
+                    return;
+                }
+
+                // Normal masked write: keep RO bits(EMPTY) as oldValue, take RW bits(ACTIVE, ENABLE) from new value
+                trFunnelControl_.store(tci::tr_tf::TR_FUNNEL_CONTROL_REG.applyWrite(oldValue, value), std::memory_order_relaxed);
+
+                break;
+            }
+            case tci::tr_tf::TR_FUNNEL_DIS_INPUT: {
+                // take RW bits from new value (WARL-normalized)
+                trFunnelDisInput_.store(tci::tr_tf::TR_FUNNEL_DIS_INPUT_REG.applyWrite(0, value), std::memory_order_relaxed);
+                break;
+            }
+            default:
+                TCI_LOG_WARN("[TraceFunnel::write32] Invalid offset: " << offset);
+            break;
+        }
+    }
+    
+    private:
+        // Per-input adapter handed to an encoder's connect()
+        class Input : public TraceBytesConnect {
+        public:
+            using TraceBytesConnect::pushBytes;
+            bool pushBytes(const std::uint8_t* data, std::size_t length) override {
+                return funnel_->pushFrom(index_, data, length);
+            }
+            bool pushBytesStalling(const std::uint8_t* data, std::size_t length) override {
+                return funnel_->pushFrom(index_, data, length, true);
+            }
+            TraceFunnel* funnel_ = nullptr;
+            std::uint32_t index_ = 0;
+
+            // Input queue: frames (packet::frame header + payload) between monotonic byte counters
+            std::vector<std::uint8_t> ring;
+            alignas(64) std::atomic<std::uint64_t> head{0}; // written by the producer
+            alignas(64) std::atomic<std::uint64_t> tail{0}; // written by the merge stage
+            std::uint32_t weight = 1;
+            std::atomic<bool> overflowed{false}; // downstream rejected merged data: reported on the next push
+        };
+
+        void copyIn(Input& in, std::uint64_t pos, const std::uint8_t* src, std::size_t n) {
+            const std::size_t at = static_cast<std::size_t>(pos) & queueMask_;
+            const std::size_t first = (n < in.ring.size() - at) ? n : in.ring.size() - at;
+            std::memcpy(in.ring.data() + at, src, first);
+            std::memcpy(in.ring.data(), src + first, n - first);
+        }
+
+        void copyOut(const Input& in, std::uint64_t pos, std::uint8_t* dst, std::size_t n) const {
+            const std::size_t at = static_cast<std::size_t>(pos) & queueMask_;
+            const std::size_t first = (n < in.ring.size() - at) ? n : in.ring.size() - at;
+            std::memcpy(dst, in.ring.data() + at, first);
+            std::memcpy(dst + first, in.ring.data(), n - first);
+        }
+
+        // Queue entry: 4-byte little-endian header (payload length, QUEUE_CONTINUED when the push goes on
+        // in the next entry, QUEUE_STALL when it came from pushBytesStalling) followed by the payload
+        static constexpr std::uint32_t QUEUE_CONTINUED = 0x1u << 31;
+        static constexpr std::uint32_t QUEUE_STALL = 0x1u << 30;
+        static constexpr std::uint32_t QUEUE_LENGTH_MASK = QUEUE_STALL - 1;
+        static constexpr std::size_t NO_INPUT = static_cast<std::size_t>(-1);
+
+        // Producer side: a push becomes one or more entries, each published only once complete.
+        // Drop mode takes a push whole or not at all: a partly queued push would leave the merge
+        // stage waiting (sticky) for a continuation that never comes. stall overrides Drop.
+        bool enqueue(Input& in, const std::uint8_t* data, std::size_t length, bool stall) {
+            if (backpressure_ == Backpressure::Drop && !stall) {
+                const std::size_t entries = (length + maxFramePayload_ - 1) / maxFramePayload_;
+                const std::size_t need = length + entries * packet::frame::HEADER_BYTES;
+                const std::uint64_t head = in.head.load(std::memory_order_relaxed);
+                if (in.ring.size() - static_cast<std::size_t>(head - in.tail.load(std::memory_order_acquire)) < need) {
+                    droppedQueueFull_.fetch_add(length, std::memory_order_relaxed);
+                    in.overflowed.store(false, std::memory_order_relaxed); // reported by this false
+                    return false;
+                }
+            }
+            while (length > 0) {
+                const std::size_t n = (length < maxFramePayload_) ? length : maxFramePayload_;
+                const std::size_t need = packet::frame::HEADER_BYTES + n;
+                const std::uint64_t head = in.head.load(std::memory_order_relaxed);
+                // Stall: wait for room per entry (Drop checked the whole push above; free space only grows)
+                while (in.ring.size() - static_cast<std::size_t>(head - in.tail.load(std::memory_order_acquire)) < need) {
+                    if (pump() == 0) std::this_thread::yield();
+                }
+                std::uint8_t header[packet::frame::HEADER_BYTES];
+                const std::uint32_t value = static_cast<std::uint32_t>(n) | ((length > n) ? QUEUE_CONTINUED : 0u) | (stall ? QUEUE_STALL : 0u);
+                for (std::size_t b = 0; b < packet::frame::HEADER_BYTES; ++b) header[b] = static_cast<std::uint8_t>(value >> (8 * b));
+                copyIn(in, head, header, packet::frame::HEADER_BYTES);
+                copyIn(in, head + packet::frame::HEADER_BYTES, data, n);
+                in.head.store(head + need, std::memory_order_release);
+                data += n;
+                length -= n;
+            }
+            return !in.overflowed.exchange(false, std::memory_order_relaxed);
+        }
+
+        // Merge side (mergeMutex_ held): move up to weight * MERGE_QUANTUM bytes of whole pushes downstream
+        // in one push, adding a packet::frame header per entry when source tagging is on. A push split over
+        // several entries is never interleaved with other inputs: the input stays sticky until it completes.
+        std::size_t mergeInput(Input& in) {
+            std::uint64_t tail = in.tail.load(std::memory_order_relaxed);
+            const std::uint64_t head = in.head.load(std::memory_order_acquire);
+            if (tail == head) return 0;
+
+            const std::size_t budget = static_cast<std::size_t>(in.weight) * MERGE_QUANTUM;
+            std::size_t taken = 0;
+            bool continued = (sticky_ == in.index_);
+            bool stall = (backpressure_ == Backpressure::Stall);
+            mergeBuf_.clear();
+            while (tail != head && (taken < budget || continued)) {
+                std::uint8_t bytes[packet::frame::HEADER_BYTES];
+                copyOut(in, tail, bytes, packet::frame::HEADER_BYTES);
+                const std::uint32_t entry = static_cast<std::uint32_t>(bytes[0]) | (static_cast<std::uint32_t>(bytes[1]) << 8) |
+                                            (static_cast<std::uint32_t>(bytes[2]) << 16) | (static_cast<std::uint32_t>(bytes[3]) << 24);
+                const std::size_t n = entry & QUEUE_LENGTH_MASK;
+                continued = (entry & QUEUE_CONTINUED) != 0;
+                stall = stall || (entry & QUEUE_STALL) != 0;
+                std::size_t at = mergeBuf_.size();
+                if (sourceTagging_) {
+                    const std::uint32_t header = packet::frame::header(sourceIdBase_ + in.index_, n);
+                    mergeBuf_.resize(at + packet::frame::HEADER_BYTES);
+                    for (std::size_t b = 0; b < packet::frame::HEADER_BYTES; ++b) mergeBuf_[at + b] = static_cast<std::uint8_t>(header >> (8 * b));
+                    at += packet::frame::HEADER_BYTES;
+                }
+                mergeBuf_.resize(at + n);
+                copyOut(in, tail + packet::frame::HEADER_BYTES, mergeBuf_.data() + at, n);
+                tail += packet::frame::HEADER_BYTES + n;
+                taken += packet::frame::HEADER_BYTES + n;
+            }
+            if (out_) {
+                const bool accepted = stall ? out_->pushBytesStalling(mergeBuf_.data(), mergeBuf_.size())
+                                            : out_->pushBytes(mergeBuf_.data(), mergeBuf_.size());
+                if (!accepted) {
+                    droppedDownstream_.fetch_add(mergeBuf_.size(), std::memory_order_relaxed);
+                    in.overflowed.store(true, std::memory_order_relaxed);
+                }
+            } else {
+                droppedNoOutput_.fetch_add(mergeBuf_.size(), std::memory_order_relaxed);
+            }
+            in.tail.store(tail, std::memory_order_release); // after the push, so trFunnelEmpty implies delivered
+            sticky_ = continued ? in.index_ : NO_INPUT;
+            return taken;
+        }
+
+        bool queuesEmpty() const {
+            for (const auto& in : inputs_) {
+                if (in.head.load(std::memory_order_acquire) != in.tail.load(std::memory_order_acquire)) return false;
+            }
+            return true;
+        }
+
+        // Header and payload go downstream in one push, so a sink never keeps a header without its payload
+        bool pushFramed(std::uint32_t sourceId, const std::uint8_t* data, std::size_t length, bool stall) {
+            bool accepted = true;
+            while (length > 0) {
+                const std::size_t n = (length < packet::frame::MAX_PAYLOAD) ? length : packet::frame::MAX_PAYLOAD;
+                const std::uint32_t header = packet::frame::header(sourceId, n);
+                frame_.resize(packet::frame::HEADER_BYTES + n);
+                for (std::size_t b = 0; b < packet::frame::HEADER_BYTES; ++b) {
+                    frame_[b] = static_cast<std::uint8_t>(header >> (8 * b));
+                }
+                std::memcpy(frame_.data() + packet::frame::HEADER_BYTES, data, n);
+                accepted = (stall ? out_->pushBytesStalling(frame_.data(), frame_.size())
+                                  : out_->pushBytes(frame_.data(), frame_.size())) && accepted;
+                data += n;
+                length -= n;
+            }
+            return accepted;
+        }
+
+        TraceBytesConnect* out_ = nullptr;
+        std::array<Input, MAX_INPUTS> inputs_;
+        bool sourceTagging_ = false;
+        std::uint32_t sourceIdBase_ = 0;
+        std::vector<std::uint8_t> frame_; // framing scratch buffer
+
+        bool queued_ = false;
+        Backpressure backpressure_ = Backpressure::Stall;
+        std::size_t queueMask_ = 0;
+        std::size_t maxFramePayload_ = packet::frame::MAX_PAYLOAD;
+        std::mutex mergeMutex_; // serializes merge rounds (merge thread, stalled producers, disable)
+        std::vector<std::uint8_t> mergeBuf_;
+        std::size_t sticky_ = NO_INPUT; // input whose split push is partly merged
+        std::thread merger_;
+        std::atomic<bool> merging_{false};
+        
+        // Atomic: read by producer threads, written through MMIO
+        std::atomic<std::uint32_t> trFunnelControl_{0}; // enable = 0 (default)
+        std::atomic<std::uint32_t> trFunnelDisInput_{0};
+        std::atomic<std::uint64_t> droppedDisabled_{0};
+        std::atomic<std::uint64_t> droppedNoOutput_{0};
+        std::atomic<std::uint64_t> droppedQueueFull_{0};
+        std::atomic<std::uint64_t> droppedDownstream_{0};
+    };
+}
@@ -0,0 +1,95 @@
+#pragma once
+#include <iostream>
+#include <sstream>
+#include <string>
+
+// Component diagnostics with compile-time level filtering.
+//   TCI_LOG_LEVEL: 0 = off, 1 = error, 2 = warn, 3 = info, 4 = debug
+//   Default: warn in release (NDEBUG), info otherwise. Messages above the level are removed
+//   by the preprocessor, including their strings and formatting.
+// Hot-path events (emitting while disabled, no output connected) are logged at debug level;
+// the components count them instead (see their diagnostic counters).
+#define TCI_LOG_LEVEL_OFF   0
+#define TCI_LOG_LEVEL_ERROR 1
+#define TCI_LOG_LEVEL_WARN  2
+#define TCI_LOG_LEVEL_INFO  3
+#define TCI_LOG_LEVEL_DEBUG 4
+
+#ifndef TCI_LOG_LEVEL
+#ifdef NDEBUG
+#define TCI_LOG_LEVEL TCI_LOG_LEVEL_WARN
+#else
+#define TCI_LOG_LEVEL TCI_LOG_LEVEL_INFO
+#endif
+#endif
+
+namespace tci {
+    namespace log {
+        enum class Level { Error = TCI_LOG_LEVEL_ERROR, Warn = TCI_LOG_LEVEL_WARN,
+                           Info = TCI_LOG_LEVEL_INFO, Debug = TCI_LOG_LEVEL_DEBUG };
+
+        // Global log sink; the default writes one line per message to std::cout
+        class LogSink {
+        public:
+            virtual ~LogSink() = default;
+            virtual void write(Level level, const std::string& message) = 0;
+        };
+
+        class CoutSink : public LogSink {
+        public:
+            void write(Level, const std::string& message) override {
+                std::cout << message << '\n';
+            }
+        };
+
+        inline LogSink& defaultSink() {
+            static CoutSink coutSink;
+            return coutSink;
+        }
+
+        inline LogSink*& sinkSlot() {
+            static LogSink* sink = &defaultSink();
+            return sink;
+        }
+
+        // nullptr restores the std::cout sink
+        inline void setSink(LogSink* sink) {
+            sinkSlot() = sink ? sink : &defaultSink();
+        }
+
+        inline void emit(Level level, const std::ostringstream& message) {
+            sinkSlot()->write(level, message.str());
+        }
+    }
+}
+
+#define TCI_LOG_AT(lvl, stream_expr) \
+    do { \
+        std::ostringstream tci_log_os_; \
+        tci_log_os_ << stream_expr; \
+        ::tci::log::emit(::tci::log::Level::lvl, tci_log_os_); \
+    } while (0)
+
+#if TCI_LOG_LEVEL >= TCI_LOG_LEVEL_ERROR
+#define TCI_LOG_ERROR(stream_expr) TCI_LOG_AT(Error, stream_expr)
+#else
+#define TCI_LOG_ERROR(stream_expr) do {} while (0)
+#endif
+
+#if TCI_LOG_LEVEL >= TCI_LOG_LEVEL_WARN
+#define TCI_LOG_WARN(stream_expr) TCI_LOG_AT(Warn, stream_expr)
+#else
+#define TCI_LOG_WARN(stream_expr) do {} while (0)
+#endif
+
+#if TCI_LOG_LEVEL >= TCI_LOG_LEVEL_INFO
+#define TCI_LOG_INFO(stream_expr) TCI_LOG_AT(Info, stream_expr)
+#else
+#define TCI_LOG_INFO(stream_expr) do {} while (0)
+#endif
+
+#if TCI_LOG_LEVEL >= TCI_LOG_LEVEL_DEBUG
+#define TCI_LOG_DEBUG(stream_expr) TCI_LOG_AT(Debug, stream_expr)
+#else
+#define TCI_LOG_DEBUG(stream_expr) do {} while (0)
+#endif
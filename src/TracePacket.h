@@ -0,0 +1,116 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+namespace tci {
+    // Delta instruction trace format (trTeFormat = TR_TE_FORMAT_DELTA), shared by TraceEncoder and TraceDecoder.
+    //
+    // Every packet starts with a header byte: bits[1:0] = type, bits[7:2] = value.
+    // Values 0..62 are stored inline; 63 means the value is (63 + unsigned LEB128 varint that follows).
+    //   PAD     (0): header 0x00, fills the stream up to a 4-byte boundary on flush
+    //   RUN     (1): value = number of sequential instructions, each at previous pc + 4
+    //   DELTA   (2): one instruction at previous pc + 4 + zigzag-decoded value (discontinuity)
+    //   ADDRESS (3): value 0, followed by the full 32-bit pc (little-endian); first instruction after enable
+    //   SYNC       : SYNC_MARKER (6 x 0xFF, 0x5C) followed by the full 32-bit pc; self-contained restart point
+    //                emitted periodically (trTeInstSyncMode / trTeInstSyncMax)
+    // Outside a SYNC marker the stream never holds more than 4 consecutive 0xFF bytes (header 0xFF is
+    // never emitted, pcs are 2-byte aligned, a 32-bit varint has at most 4 continuation bytes), so the
+    // marker can be found by scanning from any byte offset.
+    namespace packet {
+        static constexpr std::uint8_t TYPE_PAD     = 0;
+        static constexpr std::uint8_t TYPE_RUN     = 1;
+        static constexpr std::uint8_t TYPE_DELTA   = 2;
+        static constexpr std::uint8_t TYPE_ADDRESS = 3;
+        static constexpr std::uint8_t TYPE_MASK    = 0x3u;
+        static constexpr std::uint32_t INLINE_MAX  = 63; // value field escape
+
+        static constexpr std::uint32_t INST_BYTES  = 4; // sequential step
+        static constexpr std::size_t MAX_PACKET_BYTES = 1 + 5; // header + 32-bit varint
+
+        static constexpr std::uint8_t SYNC_MARKER[] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x5C};
+        static constexpr std::size_t SYNC_MARKER_BYTES = sizeof(SYNC_MARKER);
+        static constexpr std::size_t SYNC_BYTES = SYNC_MARKER_BYTES + 4;
+        static constexpr std::size_t NO_SYNC = static_cast<std::size_t>(-1);
+
+        // Offset of the first SYNC packet starting at or after `from`, or NO_SYNC
+        inline std::size_t findSync(const std::uint8_t* src, std::size_t size, std::size_t from) {
+            std::size_t ffRun = 0;
+            for (std::size_t i = from; i < size; ++i) {
+                if (src[i] == 0xFF) {
+                    ++ffRun;
+                } else {
+                    if (src[i] == SYNC_MARKER[SYNC_MARKER_BYTES - 1] && ffRun >= SYNC_MARKER_BYTES - 1) {
+                        return i - (SYNC_MARKER_BYTES - 1);
+                    }
+                    ffRun = 0;
+                }
+            }
+            return NO_SYNC;
+        }
+
+        inline std::uint32_t zigzag(std::int32_t v) {
+            return (static_cast<std::uint32_t>(v) << 1) ^ static_cast<std::uint32_t>(v >> 31);
+        }
+        inline std::int32_t unzigzag(std::uint32_t v) {
+            return static_cast<std::int32_t>(v >> 1) ^ -static_cast<std::int32_t>(v & 1);
+        }
+
+        // Writes header (+ varint) for type/value at dst, returns bytes written (<= MAX_PACKET_BYTES)
+        inline std::size_t put(std::uint8_t* dst, std::uint8_t type, std::uint32_t value) {
+            if (value < INLINE_MAX) {
+                dst[0] = static_cast<std::uint8_t>(type | (value << 2));
+                return 1;
+            }
+            dst[0] = static_cast<std::uint8_t>(type | (INLINE_MAX << 2));
+            std::uint32_t rest = value - INLINE_MAX;
+            std::size_t n = 1;
+            while (rest >= 0x80) {
+                dst[n++] = static_cast<std::uint8_t>(rest | 0x80);
+                rest >>= 7;
+            }
+            dst[n++] = static_cast<std::uint8_t>(rest);
+            return n;
+        }
+
+        // Reads header (+ varint) at src[pos]; returns false if the packet is truncated or malformed
+        inline bool get(const std::uint8_t* src, std::size_t size, std::size_t& pos, std::uint8_t& type, std::uint32_t& value) {
+            if (pos >= size) return false;
+            const std::uint8_t header = src[pos++];
+            type = header & TYPE_MASK;
+            value = header >> 2;
+            if (value < INLINE_MAX) return true;
+            std::uint32_t rest = 0;
+            for (std::uint32_t shift = 0; shift < 35; shift += 7) {
+                if (pos >= size) return false;
+                const std::uint8_t b = src[pos++];
+                rest |= static_cast<std::uint32_t>(b & 0x7F) << shift;
+                if ((b & 0x80) == 0) {
+                    value = INLINE_MAX + rest;
+                    return true;
+                }
+            }
+            return false; // varint longer than 5 bytes
+        }
+
+        // Funnel source framing (TraceFunnel::setSourceTagging): with several inputs sharing one sink, each
+        // push from input i is wrapped in frames of a 4-byte little-endian header followed by the payload.
+        //   header bits[3:0] = MAGIC, bits[15:4] = source ID, bits[31:16] = payload length in bytes
+        // Payloads of one source concatenated in order give that encoder's original byte stream.
+        namespace frame {
+            static constexpr std::uint32_t MAGIC        = 0xAu;
+            static constexpr std::uint32_t MAGIC_MASK   = 0xFu;
+            static constexpr std::uint32_t SOURCE_SHIFT = 4;
+            static constexpr std::uint32_t SOURCE_MASK  = 0xFFFu; // after shift: 4096 source IDs
+            static constexpr std::uint32_t LENGTH_SHIFT = 16;
+            static constexpr std::size_t HEADER_BYTES   = 4;
+            static constexpr std::size_t MAX_PAYLOAD    = 0xFFFF;
+
+            inline std::uint32_t header(std::uint32_t sourceId, std::size_t length) {
+                return MAGIC | ((sourceId & SOURCE_MASK) << SOURCE_SHIFT) | (static_cast<std::uint32_t>(length) << LENGTH_SHIFT);
+            }
+            inline bool isHeader(std::uint32_t h) { return (h & MAGIC_MASK) == MAGIC; }
+            inline std::uint32_t sourceId(std::uint32_t h) { return (h >> SOURCE_SHIFT) & SOURCE_MASK; }
+            inline std::size_t length(std::uint32_t h) { return h >> LENGTH_SHIFT; }
+        }
+    }
+}
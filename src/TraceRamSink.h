@@ -1,224 +1,413 @@
-#pragma once
-
-#include <iostream>
-#include <vector>
-#include <cstdint>
-#include "TraceBytesConnect.h"
-#include "IMmioDevice.h"
-#include "TraceControlRegisters.h"
-
-
-namespace tci {
-    class TraceRamSink : public TraceBytesConnect, public IMmioDevice {
-    public:
-    TraceRamSink(std::uint32_t bufSize) : bufferSize_(bufSize) {
-        dataBuffer_.resize(bufferSize_, 0);
-        trRamControl_ = 0; // default control value with all bits cleared
-        setEmpty(true); // initially empty
-    }
-    
-    ~TraceRamSink() {
-    }
-        
-    void pushBytes(const std::uint8_t* data, std::size_t length) override {
-        const bool active = (trRamControl_ & tci::tr_ram::TR_RAM_ACTIVE) != 0;
-        const bool enable = (trRamControl_ & tci::tr_ram::TR_RAM_ENABLE) != 0;
-
-        if(!active || !enable) {
-            std::cout << "[TraceRamSink::pushBytes] Trace RAM sinking is disabled" << std::endl;
-            return;
-        }
-
-        // Policy: DROP-WHEN-FULL (no overwrite, no wrap modeling)
-        for (std::size_t i = 0; i < length; ++i) {
-            if (count_ == dataBuffer_.size()) {
-                // Drop remaining bytes; do not modify pointers or count_.
-                droppedBytes_ += static_cast<std::uint32_t>(length - i);
-                break;
-            }
-
-            dataBuffer_[wpByte_] = data[i];
-            wpByte_ = (wpByte_ + 1) % dataBuffer_.size();
-            ++count_;
-
-            // Any successful write means not empty anymore
-            setEmpty(false);
-        }
-    }
-
-    // void printDataBuffer() {
-    //     std::cout << "[TraceRamSink::printDataBuffer] Data buffer contents: ";
-    //     for (const auto& byte : dataBuffer_) {
-    //         std::cout << std::hex << static_cast<int>(byte) << " ";
-    //     }
-    //     std::cout << std::dec << std::endl; // reset to decimal
-    // }
-
-    std::uint32_t read32(std::uint32_t offset) override {
-        switch (offset) {
-            case tci::tr_ram::TR_RAM_CONTROL:
-                updateEmptyFromCount();
-                return trRamControl_;
-            case tci::tr_ram::TR_RAM_WP_LOW:
-                // Simplified: WRAP bit[0] always reads 0; pointer in [31:2]
-                return encodePtrAligned(wpByte_) & tci::tr_ram::TR_RAM_WP_LOW_MASK;
-            case tci::tr_ram::TR_RAM_RP_LOW:
-                return encodePtrAligned(rpByte_) & tci::tr_ram::TR_RAM_RP_LOW_MASK;
-            case tci::tr_ram::TR_RAM_DATA:
-                return pop_u32_le(); // advances RP by 4 when successful
-            default:
-                std::cout << "[TraceRamSink::read32] Invalid offset: " << offset << std::endl;
-                return 0;
-        }
-    }
-
-    void write32(std::uint32_t offset, std::uint32_t value) override {
-        switch (offset) {
-            case tci::tr_ram::TR_RAM_CONTROL: {
-                const std::uint32_t oldValue = trRamControl_;
-
-                const bool newActive = (value & tci::tr_ram::TR_RAM_ACTIVE) != 0;
-                if(!newActive) {
-                    trRamControl_ = 0; // reset all control bits to default values when deactivating
-                    resetDataBuffer();
-                    setEmpty(true); // set empty when deactivated
-                    std::cout << "[TraceRamSink::write32] Trace RAM sinking deactivated, internal state reset, control bits cleared" << std::endl;
-                    return;
-                }
-
-                // Normal masked write
-                // keep RO bits(EMPTY) as oldValue
-                const std::uint32_t keep_ro = oldValue & tci::tr_ram::TR_RAM_CONTROL_RO_MASK;
-                // Take RW bits(ACTIVE, ENABLE, MODE, STOP_ON_WRAP, MEM_FORMAT, ASYNC_FREQ) from new value
-                std::uint32_t new_rw  = value & tci::tr_ram::TR_RAM_CONTROL_RW_MASK;
-                
-                new_rw = normalizeWarlFields(new_rw);
-                
-                trRamControl_ = keep_ro | new_rw;
-
-                // Internal status refresh
-                updateEmptyFromCount();
-                break;
-            }
-            case tci::tr_ram::TR_RAM_WP_LOW:
-                // ignore writes to WP_LOW
-                break;
-            case tci::tr_ram::TR_RAM_RP_LOW:
-                // - SW may advance RP forward to consume data without reading DATA.
-                // - Backward moves are ignored (ambiguous).
-                // apply_rp_write_forward_only(value);
-                break;
-            case tci::tr_ram::TR_RAM_DATA:
-                // read-only data port // ignore writes to DATA
-                break;
-            default:
-                std::cout << "[TraceRamSink::write32] Invalid offset: " << offset << std::endl;
-                break;
-        }
-    }
-
-    private:
-    static std::uint32_t normalizeWarlFields(std::uint32_t rw_value) {
-        // WARL-lite: clamp fields to legal bitwidth and (optionally) supported subset.
-
-        auto clampField = [&](std::uint32_t mask, std::uint32_t shift, std::uint32_t max_val) {
-            std::uint32_t v = (rw_value & mask) >> shift;
-            if (v > max_val) v = max_val; // clamp
-            rw_value = (rw_value & ~mask) | ((v << shift) & mask);
-        };
-
-        // trRamMemFormat is 2 bits [10:9] -> legal 0..3
-        clampField(tci::tr_ram::TR_RAM_MEM_FORMAT_MASK,
-                    tci::tr_ram::TR_RAM_MEM_FORMAT_SHIFT,
-                    3u);
-
-        // trRamAsyncFreq is 3 bits [14:12] -> legal 0..7
-        clampField(tci::tr_ram::TR_RAM_ASYNC_FREQ_MASK,
-                    tci::tr_ram::TR_RAM_ASYNC_FREQ_SHIFT,
-                    7u);
-        
-        return rw_value;
-    }
-
-    // Align pointer to 4 bytes for register view ([31:2])
-    static std::uint32_t encodePtrAligned(std::uint32_t byte_index) {
-        return (byte_index & ~0x3u); // clear low 2 bits
-    }
-
-    void setEmpty(bool is_empty) {
-        if (is_empty) trRamControl_ |= tci::tr_ram::TR_RAM_EMPTY;
-        else          trRamControl_ &= ~tci::tr_ram::TR_RAM_EMPTY;
-    }
-
-    void updateEmptyFromCount() {
-        setEmpty(count_ == 0);
-    }
-
-    private:
-    // Pop one 32-bit word (little-endian) if available; advances RP by 4 bytes
-    std::uint32_t pop_u32_le() {
-        // Require 4 bytes to read a word
-        if (count_ < 4 || dataBuffer_.empty()) {
-            updateEmptyFromCount(); // do NOT set empty unless count_==0
-            return 0;
-        }
-
-        std::uint32_t value = 0;
-        for (int i = 0; i < 4; ++i) {
-            value |= static_cast<std::uint32_t>(dataBuffer_[rpByte_]) << (8 * i);
-            rpByte_ = (rpByte_ + 1) % dataBuffer_.size();
-        }
-        count_ -= 4;
-
-        updateEmptyFromCount();
-        return value;
-    }
-
-    // Optional: allow software to advance RP (consume) without reading DATA.
-    // Forward-only; clamps to available data.
-    // void apply_rp_write_forward_only(std::uint32_t value) {
-    //     if (dataBuffer_.empty()) return;
-
-    //     // Only consider aligned pointer bits [31:2]
-    //     std::uint32_t new_ptr = value & tci::tr_ram::TR_RAM_RP_LOW_MASK;
-    //     std::uint32_t new_rp = (new_ptr % static_cast<std::uint32_t>(dataBuffer_.size())) & ~0x3u;
-
-    //     const std::uint32_t size = static_cast<std::uint32_t>(dataBuffer_.size());
-    //     const std::uint32_t old_rp = rpByte_ & ~0x3u;
-
-    //     // forward distance in ring
-    //     std::uint32_t forward = 0;
-    //     if (new_rp >= old_rp) forward = new_rp - old_rp;
-    //     else forward = (size - old_rp) + new_rp;
-
-    //     if (forward > count_) forward = count_; // cannot consume more than available
-
-    //     rpByte_ = (rpByte_ + forward) % size;
-    //     count_ -= forward;
-
-    //     updateEmptyFromCount();
-    // }
-
-    void resetDataBuffer() {
-        std::fill(dataBuffer_.begin(), dataBuffer_.end(), 0); // Clear the buffer
-        wpByte_ = 0;
-        rpByte_ = 0;
-        count_ = 0;
-    }
-
-    private:
-    std::uint32_t trRamControl_ = 0; // enable = 0 (default)
-    std::vector<std::uint8_t> dataBuffer_;
-    std::uint32_t bufferSize_ = 1024; // default buffer size in bytes (256 words)
-
-    std::uint32_t count_ = 0;
-
-    // Internal pointers are byte indices (0..size-1)
-    // WP/RP are modeled as offsets within the sink’s internal buffer, not physical addresses.
-    std::uint32_t wpByte_ = 0;
-    std::uint32_t rpByte_ = 0;
-
-    std::uint32_t droppedBytes_ = 0;
-
-    };
-}
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <atomic>
+#include "TraceBytesConnect.h"
+#include "TraceLog.h"
+#include "IMmioDevice.h"
+#include "TraceControlRegisters.h"
+
+
+namespace tci {
+    // Thread safety: one producer (pushBytes) and one consumer (TR_RAM_DATA / pointer and
+    // control reads) may run concurrently; the ring is a lock-free SPSC queue on the
+    // monotonic byte counters head_/tail_. Register writes (control, bounds) must not race
+    // with an active producer; the wrap acknowledge (TR_RAM_WP_LOW) may.
+    class TraceRamSink : public TraceBytesConnect, public IMmioDevice {
+    public:
+    // What happens when the producer runs into unread data
+    enum class FullPolicy {
+        DropWhenFull, // keep the oldest data, drop new bytes (default)
+        Circular      // overwrite the oldest data, keep the newest bufferSize bytes
+    };
+
+    TraceRamSink(std::uint32_t bufSize, FullPolicy policy = FullPolicy::DropWhenFull)
+        : bufferSize_(bufSize), policy_(policy) {
+        dataBuffer_.resize(bufferSize_, 0);
+        selectStorage(); // SRAM until TR_RAM_MODE selects SMEM
+        trRamControl_ = 0; // default control value with all bits cleared (EMPTY is derived from the counters)
+    }
+    
+    ~TraceRamSink() {
+    }
+        
+    bool pushBytes(const std::uint8_t* data, std::size_t length) override {
+        const std::uint32_t ctrl = trRamControl_.load(std::memory_order_relaxed);
+        const bool active = (ctrl & tci::tr_ram::TR_RAM_ACTIVE) != 0;
+        const bool enable = (ctrl & tci::tr_ram::TR_RAM_ENABLE) != 0;
+
+        if(!active || !enable) {
+            droppedDisabled_.fetch_add(length, std::memory_order_relaxed);
+            TCI_LOG_DEBUG("[TraceRamSink::pushBytes] Trace RAM sinking is disabled");
+            return true; // counted, not an overflow
+        }
+
+        if (ringSize_ == 0) { // SMEM selected without a valid buffer window
+            droppedBytes_.fetch_add(static_cast<std::uint32_t>(length), std::memory_order_relaxed);
+            return false;
+        }
+
+        // Producer owns head_; tail_ is only read here (or pushed forward on overwrite)
+        const std::uint64_t head = head_.load(std::memory_order_relaxed);
+        const std::uint64_t tail = tail_.load(std::memory_order_acquire);
+        const std::uint32_t count = static_cast<std::uint32_t>(head - tail);
+        const std::uint32_t wpByte = index(head);
+
+        // Copy whatever is stored in at most two contiguous segments (pre-wrap and post-wrap)
+        const bool stopOnWrap = (ctrl & tci::tr_ram::TR_RAM_STOP_ON_WRAP) != 0;
+        std::uint32_t space = ringSize_ - count;
+        if (policy_ == FullPolicy::Circular && !stopOnWrap) {
+            // Only the newest ringSize_ bytes of an oversized push can survive
+            if (length > ringSize_) {
+                overwrittenBytes_.fetch_add(static_cast<std::uint32_t>(length - ringSize_), std::memory_order_relaxed);
+                data += length - ringSize_;
+                length = ringSize_;
+            }
+            space = ringSize_;
+        }
+        std::uint32_t n = (length < space) ? static_cast<std::uint32_t>(length) : space;
+        if (stopOnWrap && n > ringSize_ - wpByte) {
+            n = ringSize_ - wpByte; // stop exactly where WP wraps
+        }
+        if (n < length) {
+            // Drop remaining bytes; pointers only cover what was stored.
+            droppedBytes_.fetch_add(static_cast<std::uint32_t>(length - n), std::memory_order_relaxed);
+        }
+        if (n == 0) return false;
+
+        if (count + n > ringSize_) {
+            // Circular: unread data is about to be overwritten, the oldest valid byte becomes the new WP.
+            // Move tail_ before touching the data so a concurrent reader notices (its CAS fails).
+            const std::uint64_t newTail = head + n - ringSize_;
+            std::uint64_t t = tail;
+            while (t < newTail && !tail_.compare_exchange_weak(t, newTail, std::memory_order_acq_rel)) {}
+            if (t < newTail) overwrittenBytes_.fetch_add(static_cast<std::uint32_t>(newTail - t), std::memory_order_relaxed);
+        }
+
+        copyIn(wpByte, data, n);
+        head_.store(head + n, std::memory_order_release); // publish
+
+        if (wpByte + n >= ringSize_) {
+            wrap_.store(head + n + 1); // after head_, so an acknowledge that saw the old head keeps it
+            if (stopOnWrap) trRamControl_.fetch_and(~tci::tr_ram::TR_RAM_ENABLE); // auto-disable on wrap
+        }
+        return n == length;
+    }
+
+    // Provide the system memory (SMEM) visible to the sink: addresses
+    // [baseAddress, baseAddress + size) map onto memory[0, size), e.g. a MappedFileMemory.
+    // TR_RAM_START_LOW/TR_RAM_LIMIT_LOW select the trace buffer inside this window.
+    void attachSystemMemory(std::uint8_t* memory, std::uint32_t baseAddress, std::uint32_t size) {
+        smem_ = memory;
+        smemBase_ = baseAddress;
+        smemSize_ = size;
+        selectStorage();
+    }
+
+    // Bytes rejected because the buffer was full (model statistic, not a register)
+    std::uint32_t droppedBytes() const { return droppedBytes_.load(std::memory_order_relaxed); }
+    // Unread bytes lost to overwrite in circular mode (model statistic, not a register)
+    std::uint32_t overwrittenBytes() const { return overwrittenBytes_.load(std::memory_order_relaxed); }
+
+    // Bytes rejected because the sink was inactive or disabled
+    std::uint64_t droppedDisabledBytes() const { return droppedDisabled_.load(std::memory_order_relaxed); }
+
+    // void printDataBuffer() {
+    //     std::cout << "[TraceRamSink::printDataBuffer] Data buffer contents: ";
+    //     for (const auto& byte : dataBuffer_) {
+    //         std::cout << std::hex << static_cast<int>(byte) << " ";
+    //     }
+    //     std::cout << std::dec << std::endl; // reset to decimal
+    // }
+
+    std::uint32_t read32(std::uint32_t offset) override {
+        switch (offset) {
+            case tci::tr_ram::TR_RAM_CONTROL:
+                return trRamControl_.load(std::memory_order_relaxed) | (isEmpty() ? tci::tr_ram::TR_RAM_EMPTY : 0u);
+            case tci::tr_ram::TR_RAM_START_LOW:
+                // SRAM mode: buffer starts at 0 (pointers are offsets within the sink's buffer)
+                return isSmem() ? trRamStart_ : 0u;
+            case tci::tr_ram::TR_RAM_LIMIT_LOW:
+                return isSmem() ? trRamLimit_ : (bufferSize_ & tci::tr_ram::TR_RAM_LIMIT_LOW_MASK);
+            case tci::tr_ram::TR_RAM_WP_LOW: {
+                // WRAP bit[0] is set once WP has wrapped; pointer in [31:2]
+                const std::uint64_t head = head_.load(std::memory_order_acquire);
+                polledHead_.store(head, std::memory_order_relaxed); // what a wrap acknowledge refers to
+                return (encodePtrAligned(ringBase_ + index(head)) & tci::tr_ram::TR_RAM_WP_LOW_MASK)
+                       | (wrap_.load() != 0 ? tci::tr_ram::TR_RAM_WRAP : 0u);
+            }
+            case tci::tr_ram::TR_RAM_RP_LOW:
+                return encodePtrAligned(ringBase_ + index(tail_.load(std::memory_order_acquire))) & tci::tr_ram::TR_RAM_RP_LOW_MASK;
+            case tci::tr_ram::TR_RAM_DATA:
+                return pop_u32_le(); // advances RP by 4 when successful
+            default:
+                TCI_LOG_WARN("[TraceRamSink::read32] Invalid offset: " << offset);
+                return 0;
+        }
+    }
+
+    // Fixed-offset reads of TR_RAM_DATA drain count words in one call (FIFO-style burst)
+    void readBlock32(std::uint32_t offset, std::uint32_t* dst, std::size_t count, bool fixedOffset) override {
+        if (!fixedOffset || offset != tci::tr_ram::TR_RAM_DATA) {
+            IMmioDevice::readBlock32(offset, dst, count, fixedOffset);
+            return;
+        }
+        // Whole words available go out with one ring copy; the rest read as 0 like single reads
+        std::uint32_t words = 0;
+        for (;;) {
+            const std::uint64_t tail = tail_.load(std::memory_order_acquire);
+            const std::uint64_t head = head_.load(std::memory_order_acquire);
+            words = static_cast<std::uint32_t>((head - tail) / 4);
+            if (words > count) words = static_cast<std::uint32_t>(count);
+            if (words == 0) break;
+            copyOut(index(tail), reinterpret_cast<std::uint8_t*>(dst), words * 4);
+            if (consume(tail, words * 4)) break; // else overwritten while copying: retry from the new tail
+        }
+        fixEndianness(dst, words);
+        for (std::size_t i = words; i < count; ++i) {
+            dst[i] = 0;
+        }
+    }
+
+    void write32(std::uint32_t offset, std::uint32_t value) override {
+        switch (offset) {
+            case tci::tr_ram::TR_RAM_CONTROL: {
+                const std::uint32_t oldValue = trRamControl_.load();
+
+                const bool newActive = (value & tci::tr_ram::TR_RAM_ACTIVE) != 0;
+                if(!newActive) {
+                    trRamControl_ = 0; // reset all control bits to default values when deactivating
+                    resetDataBuffer();
+                    selectStorage(); // back to SRAM (and empty)
+                    TCI_LOG_INFO("[TraceRamSink::write32] Trace RAM sinking deactivated, internal state reset, control bits cleared");
+                    return;
+                }
+
+                // Normal masked write
+                // RO bits(EMPTY) are derived from the ring state on read, not stored (old value 0 keeps none);
+                // RW bits(ACTIVE, ENABLE, MODE, STOP_ON_WRAP, MEM_FORMAT, ASYNC_FREQ) come WARL-normalized from value
+                const std::uint32_t new_rw = tci::tr_ram::TR_RAM_CONTROL_REG.applyWrite(0, value);
+                trRamControl_ = new_rw;
+
+                // SRAM <-> SMEM switch re-targets the ring (pointers restart at the buffer start)
+                if ((oldValue ^ new_rw) & tci::tr_ram::TR_RAM_MODE) {
+                    selectStorage();
+                }
+                break;
+            }
+            case tci::tr_ram::TR_RAM_START_LOW:
+                // SMEM buffer start address; SRAM bounds are fixed at construction
+                trRamStart_ = value & tci::tr_ram::TR_RAM_START_LOW_MASK;
+                if (isSmem()) selectStorage();
+                break;
+            case tci::tr_ram::TR_RAM_LIMIT_LOW:
+                // SMEM buffer limit address (exclusive)
+                trRamLimit_ = value & tci::tr_ram::TR_RAM_LIMIT_LOW_MASK;
+                if (isSmem()) selectStorage();
+                break;
+            case tci::tr_ram::TR_RAM_WP_LOW:
+                // Pointer bits are owned by the sink; writing WRAP = 0 with the last polled WP value
+                // acknowledges the wraps up to that poll. A wrap flagged after the poll stays set.
+                if ((value & tci::tr_ram::TR_RAM_WRAP) == 0) acknowledgeWrap(value & tci::tr_ram::TR_RAM_WP_LOW_MASK);
+                break;
+            case tci::tr_ram::TR_RAM_RP_LOW:
+                // - SW may advance RP forward to consume data without reading DATA.
+                // - Backward moves are ignored (ambiguous).
+                // apply_rp_write_forward_only(value);
+                break;
+            case tci::tr_ram::TR_RAM_DATA:
+                // read-only data port // ignore writes to DATA
+                break;
+            default:
+                TCI_LOG_WARN("[TraceRamSink::write32] Invalid offset: " << offset);
+                break;
+        }
+    }
+
+    private:
+    // Align pointer to 4 bytes for register view ([31:2])
+    static std::uint32_t encodePtrAligned(std::uint32_t byte_index) {
+        return (byte_index & ~0x3u); // clear low 2 bits
+    }
+
+    bool isEmpty() const {
+        return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+    }
+
+    private:
+    // Pop one 32-bit word (little-endian) if available; advances RP by 4 bytes
+    std::uint32_t pop_u32_le() {
+        for (;;) {
+            const std::uint64_t tail = tail_.load(std::memory_order_acquire);
+            const std::uint64_t head = head_.load(std::memory_order_acquire);
+            // Require 4 bytes to read a word
+            if (head - tail < 4 || ringSize_ == 0) return 0;
+
+            const std::uint32_t rpByte = index(tail);
+            std::uint32_t value = 0;
+            if (rpByte + 4 <= ringSize_) {
+                value = load_u32_le(&storage_[rpByte]); // contiguous: single unaligned load
+            } else {
+                std::uint8_t bytes[4];
+                copyOut(rpByte, bytes, 4); // word straddles the end of the buffer
+                value = load_u32_le(bytes);
+            }
+            if (consume(tail, 4)) return value; // else overwritten while reading: retry
+        }
+    }
+
+    // Consumer commit: advance tail_ from `tail` by n. Only a circular producer can move tail_
+    // concurrently, so drop-when-full uses a plain store and circular mode validates with a CAS.
+    bool consume(std::uint64_t tail, std::uint32_t n) {
+        if (policy_ != FullPolicy::Circular) {
+            tail_.store(tail + n, std::memory_order_release);
+            return true;
+        }
+        return tail_.compare_exchange_strong(tail, tail + n, std::memory_order_acq_rel);
+    }
+
+    // Optional: allow software to advance RP (consume) without reading DATA.
+    // Forward-only; clamps to available data.
+    // void apply_rp_write_forward_only(std::uint32_t value) {
+    //     if (dataBuffer_.empty()) return;
+
+    //     // Only consider aligned pointer bits [31:2]
+    //     std::uint32_t new_ptr = value & tci::tr_ram::TR_RAM_RP_LOW_MASK;
+    //     std::uint32_t new_rp = (new_ptr % static_cast<std::uint32_t>(dataBuffer_.size())) & ~0x3u;
+
+    //     const std::uint32_t size = static_cast<std::uint32_t>(dataBuffer_.size());
+    //     const std::uint32_t old_rp = rpByte_ & ~0x3u;
+
+    //     // forward distance in ring
+    //     std::uint32_t forward = 0;
+    //     if (new_rp >= old_rp) forward = new_rp - old_rp;
+    //     else forward = (size - old_rp) + new_rp;
+
+    //     if (forward > count_) forward = count_; // cannot consume more than available
+
+    //     rpByte_ = (rpByte_ + forward) % size;
+    //     count_ -= forward;
+
+    //     updateEmptyFromCount();
+    // }
+
+    // Ring helpers: byte counter -> buffer index in [0, ringSize_), n <= ringSize_
+    std::uint32_t index(std::uint64_t counter) const {
+        if (ringMask_ != 0) return static_cast<std::uint32_t>(counter) & ringMask_;
+        return (ringSize_ != 0) ? static_cast<std::uint32_t>(counter % ringSize_) : 0u;
+    }
+
+    void copyIn(std::uint32_t pos, const std::uint8_t* src, std::uint32_t n) {
+        const std::uint32_t first = (n < ringSize_ - pos) ? n : ringSize_ - pos;
+        std::memcpy(&storage_[pos], src, first);
+        if (n > first) std::memcpy(&storage_[0], src + first, n - first);
+    }
+
+    void copyOut(std::uint32_t pos, std::uint8_t* dst, std::uint32_t n) const {
+        const std::uint32_t first = (n < ringSize_ - pos) ? n : ringSize_ - pos;
+        std::memcpy(dst, &storage_[pos], first);
+        if (n > first) std::memcpy(dst + first, &storage_[0], n - first);
+    }
+
+    static std::uint32_t load_u32_le(const std::uint8_t* p) {
+        std::uint32_t value;
+        std::memcpy(&value, p, sizeof(value));
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+        value = __builtin_bswap32(value);
+#endif
+        return value;
+    }
+
+    // Words copied straight out of the byte ring are little-endian
+    static void fixEndianness(std::uint32_t* words, std::uint32_t n) {
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+        for (std::uint32_t i = 0; i < n; ++i) words[i] = __builtin_bswap32(words[i]);
+#else
+        (void)words; (void)n;
+#endif
+    }
+
+    bool isSmem() const { return (trRamControl_.load(std::memory_order_relaxed) & tci::tr_ram::TR_RAM_MODE) != 0; }
+
+    // Point the ring at SRAM (internal buffer) or at [trRamStart_, trRamLimit_) of the attached SMEM.
+    // An SMEM window that is missing or out of range leaves a zero-sized ring (all bytes dropped).
+    void selectStorage() {
+        if (!isSmem()) {
+            storage_ = dataBuffer_.data();
+            ringBase_ = 0;
+            ringSize_ = bufferSize_;
+        } else if (smem_ && trRamLimit_ > trRamStart_ && trRamStart_ >= smemBase_
+                   && static_cast<std::uint64_t>(trRamLimit_) <= static_cast<std::uint64_t>(smemBase_) + smemSize_) {
+            storage_ = smem_ + (trRamStart_ - smemBase_);
+            ringBase_ = trRamStart_;
+            ringSize_ = trRamLimit_ - trRamStart_;
+        } else {
+            storage_ = nullptr;
+            ringBase_ = trRamStart_;
+            ringSize_ = 0;
+        }
+        // Power-of-two sizes wrap pointers with a mask instead of compare/subtract
+        ringMask_ = (ringSize_ != 0 && (ringSize_ & (ringSize_ - 1)) == 0) ? ringSize_ - 1 : 0;
+        resetPointers();
+    }
+
+    void resetPointers() {
+        head_.store(0);
+        tail_.store(0);
+        wrap_.store(0);
+        polledHead_.store(0);
+    }
+
+    // Clear trRamWrap if polledWp is the last WP read and the flagged wrap happened at or before that
+    // read (the CAS fails if the producer flags a newer one in between). Head counters, not pointers,
+    // are compared, so a wrap that brings WP back to the polled value is still kept.
+    void acknowledgeWrap(std::uint32_t polledWp) {
+        const std::uint64_t head = polledHead_.load(std::memory_order_relaxed);
+        if ((encodePtrAligned(ringBase_ + index(head)) & tci::tr_ram::TR_RAM_WP_LOW_MASK) != polledWp) return;
+        std::uint64_t flagged = wrap_.load();
+        if (flagged != 0 && flagged - 1 <= head) wrap_.compare_exchange_strong(flagged, 0);
+    }
+
+    void resetDataBuffer() {
+        if (!isSmem()) std::fill(dataBuffer_.begin(), dataBuffer_.end(), 0); // Clear the buffer (SMEM is left untouched)
+        resetPointers();
+    }
+
+    private:
+    std::atomic<std::uint32_t> trRamControl_{0}; // enable = 0 (default)
+    std::vector<std::uint8_t> dataBuffer_;
+    std::uint32_t bufferSize_ = 1024; // default buffer size in bytes (256 words)
+
+    // SMEM (TR_RAM_MODE = 1): trace buffer [trRamStart_, trRamLimit_) inside attached system memory
+    std::uint8_t* smem_ = nullptr;
+    std::uint32_t smemBase_ = 0;
+    std::uint32_t smemSize_ = 0;
+    std::uint32_t trRamStart_ = 0;
+    std::uint32_t trRamLimit_ = 0;
+
+    // Active ring: SRAM buffer or SMEM window, selected by selectStorage()
+    std::uint8_t* storage_ = nullptr;
+    std::uint32_t ringBase_ = 0; // address reported for byte index 0 (0 in SRAM mode)
+    std::uint32_t ringSize_ = 0;
+    std::uint32_t ringMask_ = 0; // ringSize_ - 1 when ringSize_ is a power of two, else 0
+
+    // Monotonic byte counters: head_ = total bytes written (producer), tail_ = total bytes consumed.
+    // Stored count = head_ - tail_; buffer index = index(counter).
+    // WP/RP registers report ringBase_ + index: offsets in SRAM mode, addresses in SMEM mode.
+    std::atomic<std::uint64_t> head_{0};
+    std::atomic<std::uint64_t> tail_{0};
+
+    std::atomic<std::uint64_t> wrap_{0}; // trRamWrap: 0 = clear, else 1 + head_ at the latest wrap
+    std::atomic<std::uint64_t> polledHead_{0}; // head_ behind the last TR_RAM_WP_LOW read
+
+    FullPolicy policy_ = FullPolicy::DropWhenFull;
+    std::atomic<std::uint32_t> droppedBytes_{0};
+    std::atomic<std::uint32_t> overwrittenBytes_{0};
+    std::atomic<std::uint64_t> droppedDisabled_{0};
+
+    };
+}
@@ -0,0 +1,212 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <string>
+#include <cstdio>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "TraceBytesConnect.h"
+
+
+namespace tci {
+    // Streaming sink: writes trace bytes continuously to a FILE* (file or pipe).
+    // The emitting thread copies into one of N buffers; a background writer thread
+    // drains full buffers to the file. The emitter only waits when every buffer is full.
+    class TraceStreamSink : public TraceBytesConnect {
+    public:
+    enum class Backpressure {
+        Stall, // all buffers full: block the emitting thread until the writer frees one
+        Drop   // push does not fit the free buffers: drop it whole, pushBytes returns false (overflow); pushBytesStalling still stalls
+    };
+
+    TraceStreamSink(std::FILE* out, std::size_t bufferBytes = 1u << 20, std::size_t bufferCount = 3,
+                    Backpressure backpressure = Backpressure::Stall)
+        : out_(out), backpressure_(backpressure) {
+        if (!out_) throw std::invalid_argument("TraceStreamSink needs an output stream");
+        init(bufferBytes, bufferCount);
+    }
+
+    TraceStreamSink(const std::string& path, std::size_t bufferBytes = 1u << 20, std::size_t bufferCount = 3,
+                    Backpressure backpressure = Backpressure::Stall)
+        : out_(std::fopen(path.c_str(), "wb")), ownsFile_(true), backpressure_(backpressure) {
+        if (!out_) throw std::runtime_error("TraceStreamSink: cannot open " + path);
+        init(bufferBytes, bufferCount);
+    }
+
+    ~TraceStreamSink() {
+        close();
+    }
+
+    TraceStreamSink(const TraceStreamSink&) = delete;
+    TraceStreamSink& operator=(const TraceStreamSink&) = delete;
+
+    bool pushBytes(const std::uint8_t* data, std::size_t length) override {
+        return push(data, length, backpressure_ == Backpressure::Stall);
+    }
+
+    // trTeInstStallEna producers stall even when the sink is set to Drop
+    bool pushBytesStalling(const std::uint8_t* data, std::size_t length) override {
+        return push(data, length, true);
+    }
+
+    // Hand the partially filled buffer to the writer and wait until everything is on disk
+    void flush() {
+        if (current_ != NO_BUFFER && buffers_[current_].used != 0) submitCurrent();
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [&] { return full_.empty() && !writing_; });
+        std::fflush(out_);
+    }
+
+    // Flush, stop the writer thread and close the file (if opened by path)
+    void close() {
+        if (!writer_.joinable()) return;
+        flush();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        cv_.notify_all();
+        writer_.join();
+        if (ownsFile_) std::fclose(out_);
+        out_ = nullptr;
+    }
+
+    // Statistics (read after flush()/close() for exact values)
+    std::uint64_t bytesWritten() const { std::lock_guard<std::mutex> lock(mutex_); return bytesWritten_; }
+    std::uint64_t droppedBytes() const { return droppedBytes_; }
+    std::uint64_t stallCount() const { return stallCount_; }
+    bool writeError() const { std::lock_guard<std::mutex> lock(mutex_); return writeError_; }
+
+    private:
+    struct Buffer {
+        std::vector<std::uint8_t> data;
+        std::size_t used = 0;
+    };
+    static constexpr std::size_t NO_BUFFER = static_cast<std::size_t>(-1);
+
+    void init(std::size_t bufferBytes, std::size_t bufferCount) {
+        if (bufferBytes == 0 || bufferCount < 2) {
+            throw std::invalid_argument("TraceStreamSink needs at least two non-empty buffers");
+        }
+        buffers_.resize(bufferCount);
+        for (std::size_t i = 0; i < bufferCount; ++i) {
+            buffers_[i].data.resize(bufferBytes);
+            if (i != 0) free_.push_back(i);
+        }
+        current_ = 0;
+        writer_ = std::thread([this] { writerLoop(); });
+    }
+
+    bool push(const std::uint8_t* data, std::size_t length, bool stall) {
+        if (!out_) { // closed
+            droppedBytes_ += length;
+            return false;
+        }
+        // Drop: the whole push or nothing, so records, packets and frames are never cut in the stream
+        if (!stall && length > room()) {
+            droppedBytes_ += length;
+            return false;
+        }
+        while (length > 0) {
+            if (current_ == NO_BUFFER && !acquireBuffer(stall)) {
+                droppedBytes_ += length;
+                return false;
+            }
+            Buffer& buf = buffers_[current_];
+            const std::size_t room = buf.data.size() - buf.used;
+            const std::size_t n = (length < room) ? length : room;
+            std::memcpy(buf.data.data() + buf.used, data, n);
+            buf.used += n;
+            data += n;
+            length -= n;
+            if (buf.used == buf.data.size()) submitCurrent();
+        }
+        return true;
+    }
+
+    // Bytes the producer can copy without waiting: rest of the current buffer plus the free buffers.
+    // Only the producer takes free buffers, so this can only grow until it pushes.
+    std::size_t room() const {
+        const std::size_t bufferBytes = buffers_[0].data.size();
+        const std::size_t current = (current_ == NO_BUFFER) ? 0 : bufferBytes - buffers_[current_].used;
+        std::lock_guard<std::mutex> lock(mutex_);
+        return current + free_.size() * bufferBytes;
+    }
+
+    // Producer side: get an empty buffer, stalling or failing when none is free
+    bool acquireBuffer(bool stall) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (free_.empty()) {
+            if (!stall) return false;
+            ++stallCount_;
+            cv_.wait(lock, [&] { return !free_.empty(); });
+        }
+        current_ = free_.front();
+        free_.pop_front();
+        return true;
+    }
+
+    void submitCurrent() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            full_.push_back(current_);
+        }
+        current_ = NO_BUFFER;
+        cv_.notify_all();
+    }
+
+    void writerLoop() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (;;) {
+            cv_.wait(lock, [&] { return stopping_ || !full_.empty(); });
+            if (full_.empty()) return; // stopping with nothing left to write
+
+            const std::size_t index = full_.front();
+            full_.pop_front();
+            writing_ = true;
+            Buffer& buf = buffers_[index];
+
+            lock.unlock(); // file I/O without holding the lock
+            const std::size_t written = std::fwrite(buf.data.data(), 1, buf.used, out_);
+            lock.lock();
+
+            if (written != buf.used) writeError_ = true;
+            bytesWritten_ += written;
+            buf.used = 0;
+            free_.push_back(index);
+            writing_ = false;
+            cv_.notify_all();
+        }
+    }
+
+    private:
+    std::FILE* out_ = nullptr;
+    bool ownsFile_ = false;
+    Backpressure backpressure_;
+
+    std::vector<Buffer> buffers_;
+    std::size_t current_ = NO_BUFFER; // buffer being filled, owned by the emitting thread
+
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<std::size_t> free_; // empty buffers
+    std::deque<std::size_t> full_; // buffers waiting for the writer
+    bool writing_ = false;
+    bool stopping_ = false;
+    bool writeError_ = false;
+    std::uint64_t bytesWritten_ = 0;
+
+    // Producer-side statistics
+    std::uint64_t droppedBytes_ = 0;
+    std::uint64_t stallCount_ = 0;
+
+    std::thread writer_;
+    };
+}
@@ -1,48 +1,170 @@
-#pragma once
-#include <cstdint>
-#include "traceEncoder.h"
-#include "traceFunnel.h"
-#include "traceRamSink.h"
-#include "MmioBus.h"
-#include <iostream>
-
-
-class TraceSystem {
-    public:
-    static constexpr uint32_t TR_TE_BASE = 0x1000;
-    static constexpr uint32_t TR_FUNNEL_BASE = 0x2000;
-    static constexpr uint32_t TR_RAM_SINK_BASE = 0x3000;
-    static constexpr uint32_t COMPONENT_SIZE = 0x1000; // 4 KB
-    
-    TraceSystem(std::uint32_t sinkRamBufferSize) : 
-        sinkRamBufferSize_(sinkRamBufferSize),         
-        encoder_(),
-        funnel_(),
-        sink_(sinkRamBufferSize_),
-        mmioBus()
-    {
-        // Connect the components
-        encoder_.connect(&funnel_);
-        funnel_.connect(&sink_);
-
-        // Map all components via MMIOBus with 0x1000 size each (4 KB)
-        mmioBus.addMapping(TR_TE_BASE, COMPONENT_SIZE, &encoder_); // TraceEncoder at 0x1000 - 0x1FFF
-        mmioBus.addMapping(TR_FUNNEL_BASE, COMPONENT_SIZE, &funnel_); // TraceFunnel at 0x2000 - 0x2FFF
-        mmioBus.addMapping(TR_RAM_SINK_BASE, COMPONENT_SIZE, &sink_); // TraceRamSink at 0x3000 - 0x3FFF
-    }
-
-    public:
-    void emitTrace(std::uint32_t pc, std::uint32_t opcode) {
-        encoder_.emitTrace(pc, opcode);
-    }
-
-    public:
-    tci::MmioBus mmioBus;
-    
-    private:
-    std::uint32_t sinkRamBufferSize_; // default buffer size for TraceRamSink in bytes
-    tci::TraceEncoder encoder_;
-    tci::TraceFunnel funnel_;
-    tci::TraceRamSink sink_;
-
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <stdexcept>
+#include "TraceEncoder.h"
+#include "TraceFunnel.h"
+#include "TraceRamSink.h"
+#include "MmioBus.h"
+#include <iostream>
+
+
+class TraceSystem {
+    public:
+    static constexpr uint32_t TR_TE_BASE = 0x1000;
+    static constexpr uint32_t TR_FUNNEL_BASE = 0x2000;
+    static constexpr uint32_t TR_RAM_SINK_BASE = 0x3000;
+    static constexpr uint32_t COMPONENT_SIZE = 0x1000; // 4 KB
+    static constexpr uint32_t TR_TE_STRIDE = 0x10000; // encoder i at TR_TE_BASE + i * TR_TE_STRIDE
+    static constexpr uint32_t TR_FUNNEL_STRIDE = 0x10000; // funnel k at TR_FUNNEL_BASE + k * TR_FUNNEL_STRIDE
+    static constexpr std::size_t MAX_ENCODERS = tci::packet::frame::SOURCE_MASK + 1; // one source ID each
+    static constexpr std::size_t MAX_FUNNELS = 4096;
+
+    static constexpr uint32_t encoderBase(std::size_t index) {
+        return TR_TE_BASE + static_cast<uint32_t>(index) * TR_TE_STRIDE;
+    }
+
+    static constexpr uint32_t funnelBase(std::size_t index) {
+        return TR_FUNNEL_BASE + static_cast<uint32_t>(index) * TR_FUNNEL_STRIDE;
+    }
+
+    // Funnel tree, root first: the root funnel has fanIn[0] inputs, each fed by a funnel with fanIn[1]
+    // inputs, and so on; the inputs of the last level are encoders. {N} is one funnel with N encoders,
+    // {8, 8} is a root funnel over 8 leaf funnels with 8 encoders each.
+    struct Topology {
+        std::vector<std::size_t> fanIn;
+    };
+    
+    // encoderCount encoders (one per hart) feed funnel inputs 0..encoderCount-1;
+    // with more than one, the funnel tags the sink stream with the source ID (= hart index)
+    TraceSystem(std::uint32_t sinkRamBufferSize,
+                tci::TraceRamSink::FullPolicy sinkPolicy = tci::TraceRamSink::FullPolicy::DropWhenFull,
+                std::size_t encoderCount = 1) :
+        TraceSystem(sinkRamBufferSize, sinkPolicy, Topology{{encoderCount}}) {}
+
+    // Funnels are numbered breadth-first (funnel 0 is the root, feeding the sink). Leaf funnels tag
+    // their pushes with the global hart index as source ID; upper levels forward frames unchanged.
+    TraceSystem(std::uint32_t sinkRamBufferSize, tci::TraceRamSink::FullPolicy sinkPolicy, const Topology& topology) : 
+        sinkRamBufferSize_(sinkRamBufferSize),         
+        encoders_(),
+        funnels_(),
+        sink_(sinkRamBufferSize_, sinkPolicy),
+        mmioBus()
+    {
+        if (topology.fanIn.empty()) throw std::invalid_argument("TraceSystem topology needs at least one funnel");
+        std::size_t encoderCount = 1;
+        std::size_t funnelCount = 0;
+        for (std::size_t fanIn : topology.fanIn) {
+            if (fanIn == 0 || fanIn > tci::TraceFunnel::MAX_INPUTS) {
+                throw std::invalid_argument("TraceSystem funnel fan-in must be 1 to 16");
+            }
+            funnelCount += encoderCount; // funnels on this level
+            encoderCount *= fanIn;
+            if (encoderCount > MAX_ENCODERS || funnelCount > MAX_FUNNELS) {
+                throw std::invalid_argument("TraceSystem supports up to 4096 encoders and 4096 funnels");
+            }
+        }
+
+        // Connect the components: funnels level by level, then encoders to the leaf funnels
+        funnels_.push_back(std::make_unique<tci::TraceFunnel>());
+        std::size_t levelStart = 0;
+        std::size_t levelCount = 1;
+        for (std::size_t level = 0; level + 1 < topology.fanIn.size(); ++level) {
+            for (std::size_t f = levelStart; f < levelStart + levelCount; ++f) {
+                for (std::size_t i = 0; i < topology.fanIn[level]; ++i) {
+                    funnels_.push_back(std::make_unique<tci::TraceFunnel>());
+                    funnels_.back()->connect(funnels_[f]->input(i));
+                }
+            }
+            levelStart += levelCount;
+            levelCount *= topology.fanIn[level];
+        }
+        const std::size_t leafFanIn = topology.fanIn.back();
+        for (std::size_t leaf = 0; leaf < levelCount; ++leaf) {
+            tci::TraceFunnel& funnel = *funnels_[levelStart + leaf];
+            funnel.setSourceTagging(encoderCount > 1);
+            funnel.setSourceIdBase(static_cast<std::uint32_t>(leaf * leafFanIn));
+            for (std::size_t i = 0; i < leafFanIn; ++i) {
+                encoders_.push_back(std::make_unique<tci::TraceEncoder>());
+                encoders_.back()->connect(funnel.input(i));
+            }
+        }
+        funnels_[0]->connect(&sink_);
+
+        // Map all components via MMIOBus with 0x1000 size each (4 KB)
+        for (std::size_t i = 0; i < encoders_.size(); ++i) {
+            mmioBus.addMapping(encoderBase(i), COMPONENT_SIZE, encoders_[i].get()); // TraceEncoder 0 at 0x1000 - 0x1FFF, 1 at 0x11000 ...
+        }
+        for (std::size_t k = 0; k < funnels_.size(); ++k) {
+            mmioBus.addMapping(funnelBase(k), COMPONENT_SIZE, funnels_[k].get()); // root TraceFunnel at 0x2000 - 0x2FFF, 1 at 0x12000 ...
+        }
+        mmioBus.addMapping(TR_RAM_SINK_BASE, COMPONENT_SIZE, &sink_); // TraceRamSink at 0x3000 - 0x3FFF
+    }
+
+    // Merge threads still running forward into their parents and the sink: stop them leaves first
+    ~TraceSystem() {
+        for (std::size_t k = funnels_.size(); k-- > 0;) funnels_[k]->stopMergeThread();
+    }
+
+    TraceSystem(const TraceSystem&) = delete;
+    TraceSystem& operator=(const TraceSystem&) = delete;
+
+    public:
+    void emitTrace(std::uint32_t pc, std::uint32_t opcode) {
+        encoders_[0]->emitTrace(pc, opcode);
+    }
+
+    void emitTrace(std::size_t hart, std::uint32_t pc, std::uint32_t opcode) {
+        encoders_[hart]->emitTrace(pc, opcode);
+    }
+
+    std::size_t encoderCount() const { return encoders_.size(); }
+
+    // Funnel setup beyond MMIO (input queues, merge thread, weights). With input queues enabled,
+    // each hart may call emitTrace(hart, ...) from its own thread.
+    tci::TraceFunnel& funnel(std::size_t index = 0) { return *funnels_.at(index); }
+    std::size_t funnelCount() const { return funnels_.size(); }
+
+    // MMIO bases of all encoders, in hart order (for TraceControllerInterface)
+    std::vector<uint32_t> encoderBases() const {
+        std::vector<uint32_t> bases;
+        for (std::size_t i = 0; i < encoders_.size(); ++i) bases.push_back(encoderBase(i));
+        return bases;
+    }
+
+    // MMIO bases of all funnels, root first (breadth-first)
+    std::vector<uint32_t> funnelBases() const {
+        std::vector<uint32_t> bases;
+        for (std::size_t k = 0; k < funnels_.size(); ++k) bases.push_back(funnelBase(k));
+        return bases;
+    }
+
+    // Route funnel output to another sink (e.g. TraceStreamSink); nullptr restores the TraceRamSink
+    void setTraceSink(tci::TraceBytesConnect* sink) {
+        funnels_[0]->connect(sink ? sink : &sink_);
+    }
+
+    // SMEM backing store for the sink (e.g. a MappedFileMemory), visible at [baseAddress, baseAddress + size)
+    void attachSinkMemory(std::uint8_t* memory, std::uint32_t baseAddress, std::uint32_t size) {
+        sink_.attachSystemMemory(memory, baseAddress, size);
+    }
+
+    void emitTraceBatch(const std::uint32_t* pcs, const std::uint32_t* opcodes, std::size_t n) {
+        encoders_[0]->emitTraceBatch(pcs, opcodes, n);
+    }
+
+    void emitTraceBatch(std::size_t hart, const std::uint32_t* pcs, const std::uint32_t* opcodes, std::size_t n) {
+        encoders_[hart]->emitTraceBatch(pcs, opcodes, n);
+    }
+
+    public:
+    tci::MmioBus mmioBus;
+    
+    private:
+    std::uint32_t sinkRamBufferSize_; // default buffer size for TraceRamSink in bytes
+    std::vector<std::unique_ptr<tci::TraceEncoder>> encoders_; // hart order; leaf funnel j has harts j * leafFanIn ...
+    std::vector<std::unique_ptr<tci::TraceFunnel>> funnels_; // breadth-first, funnels_[0] feeds the sink
+    tci::TraceRamSink sink_;
+
 };
\ No newline at end of file
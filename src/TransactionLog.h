@@ -0,0 +1,91 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <stdexcept>
+
+namespace tci {
+
+    // Fixed-size probe transaction record (24 bytes), decoded offline
+    struct TransactionRecord {
+        enum Kind : std::uint8_t { Read = 0, Write = 1, ReadBlock = 2, WriteBlock = 3 };
+
+        std::uint64_t timestampNs; // steady_clock, ns since the log was created
+        std::uint32_t address;
+        std::uint32_t value;       // data for single accesses, first word for blocks
+        std::uint32_t count;       // words (1 for single accesses); bit 31 = fixed address block
+        std::uint8_t kind;
+        std::uint8_t reserved[3];
+    };
+    static_assert(sizeof(TransactionRecord) == 24, "TransactionRecord must stay 24 bytes");
+
+    // Preallocated ring of binary transaction records. Recording is a timestamp plus one
+    // 24-byte store; when full the oldest records are overwritten.
+    class TransactionLog {
+    public:
+        static constexpr std::uint32_t FIXED_ADDRESS = 0x80000000u;
+
+        explicit TransactionLog(std::size_t capacity = 1u << 16)
+            : records_(roundUpPow2(capacity)), mask_(records_.size() - 1), epoch_(Clock::now()) {}
+
+        void record(TransactionRecord::Kind kind, std::uint32_t address, std::uint32_t value, std::uint32_t count = 1) {
+            TransactionRecord& r = records_[next_ & mask_];
+            r.timestampNs = static_cast<std::uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - epoch_).count());
+            r.address = address;
+            r.value = value;
+            r.count = count;
+            r.kind = kind;
+            ++next_;
+        }
+
+        // Records currently held (oldest first via at(0))
+        std::size_t size() const { return (next_ < records_.size()) ? static_cast<std::size_t>(next_) : records_.size(); }
+        std::size_t capacity() const { return records_.size(); }
+        std::uint64_t totalRecorded() const { return next_; }
+        std::uint64_t overwritten() const { return next_ - size(); }
+
+        const TransactionRecord& at(std::size_t i) const {
+            return records_[(next_ - size() + i) & mask_];
+        }
+
+        void clear() { next_ = 0; }
+
+        // Raw dump / reload so the decode can run in a separate tool or later session
+        void save(const std::string& path) const {
+            std::FILE* f = std::fopen(path.c_str(), "wb");
+            if (!f) throw std::runtime_error("TransactionLog: cannot open " + path);
+            for (std::size_t i = 0; i < size(); ++i) {
+                std::fwrite(&at(i), sizeof(TransactionRecord), 1, f);
+            }
+            std::fclose(f);
+        }
+
+        static std::vector<TransactionRecord> load(const std::string& path) {
+            std::FILE* f = std::fopen(path.c_str(), "rb");
+            if (!f) throw std::runtime_error("TransactionLog: cannot open " + path);
+            std::vector<TransactionRecord> out;
+            TransactionRecord r{};
+            while (std::fread(&r, sizeof(r), 1, f) == 1) out.push_back(r);
+            std::fclose(f);
+            return out;
+        }
+
+    private:
+        using Clock = std::chrono::steady_clock;
+
+        static std::size_t roundUpPow2(std::size_t n) {
+            std::size_t p = 1;
+            while (p < n) p <<= 1;
+            return p;
+        }
+
+        std::vector<TransactionRecord> records_;
+        std::size_t mask_;
+        std::uint64_t next_ = 0;
+        Clock::time_point epoch_;
+    };
+}
@@ -1,88 +1,139 @@
-/*
-    With VSCode, if you like to use CMake, the project can be built with the following command. 
-    <PowerShell terminal>
-        PS D:\Project\riscv_trace_control_interface> cmake -S . -B .\build\
-        MSBuild.exe .\build\tci.vcxproj
-        .\build\Debug\tci.exe
-*/
-
-/* 
-    Bash Terminal
-        Set GoogleTests OFF and Build 'tci_demo' exec
-        cmake -S . -B build -DTCI_BUILD_GTESTS=OFF
-        cmake --build build --target tci_demo
-        ./build/Debug/tci_demo
-
-        Set GoogleTests ON - Built both executables
-        cmake -S . -B build -DTCI_BUILD_GTESTS=ON
-        cmake --build build --target tci_demo
-        cmake --build build --target tci_gtests
-        ./build/Debug/tci_gtests
-*/
-
-#include <iostream>
-#include <vector>
-#include <cstdint>
-
-#include "TraceSystem.h"
-#include "TraceControllerInterface.h"
-#include "ProbeHwAccess.h"
-
-
-using namespace tci;
-
-int main() {
-    // Instantiate the TraceSystem with a specified buffer size (in bytes) for TraceRamSink
-    TraceSystem trSystem(1024); // Increase buffer size if needed to hold more trace data
-
-    // Create a ProbeHwAccess that uses the TraceSystem's MMIO bus
-    // ProbeHwAccess probeAccess(trSystem.mmioBus);
-
-    // Define the component regions for logging purposes
-    std::vector<ProbeHwAccess::ComponentRegion> componentRegions = {
-        {TraceSystem::TR_TE_BASE, 0x1000, "TraceEncoder"},
-        {TraceSystem::TR_FUNNEL_BASE, 0x1000, "TraceFunnel"},
-        {TraceSystem::TR_RAM_SINK_BASE, 0x1000, "TraceRamSink"}
-    };
-    ProbeHwAccess probeAccess(trSystem.mmioBus, componentRegions);
-    
-    // TraceControllerInterface takes the probe access(ReadMemory and WriteMemory stubs) and the base addresses of the components
-    tci::TraceControllerInterface trController(probeAccess, TraceSystem::TR_TE_BASE, 
-        TraceSystem::TR_FUNNEL_BASE, TraceSystem::TR_RAM_SINK_BASE);
-
-    // Configure the trace system via the TraceControllerInterface
-    std::cout << "\n Configuring Trace System... " << std::endl;
-    trController.configure();
-
-    // Simulate trace generation by setting TraceEncoder active and emitting some trace data
-    std::cout << "\n Starting Trace System..." << std::endl;
-    trController.start();
-
-    // In a real system, the TraceEncoder would emit trace data based on the execution of instructions.
-    // For this simulation, emitTrace() is called to generate some trace data.
-    trSystem.emitTrace(0x3000, 0xDEADBEEF); // example pc and opcode
-    trSystem.emitTrace(0x3004, 0xCAFEBABE); // another example pc and opcode
-    trSystem.emitTrace(0x3008, 0xAAFE1000); // another example pc and opcode
-    trSystem.emitTrace(0x300C, 0xBAFE1004); // another example pc and opcode
-    trSystem.emitTrace(0x3010, 0xEA0E1539); // another example pc and opcode
-    trSystem.emitTrace(0x3014, 0x4A2E433D); // another example pc and opcode
-
-    // Stop the trace system 
-    std::cout << "\n Stopping Trace System..." << std::endl;
-    trController.stop();
-
-    // Fetch trace data from TraceRamSink via TraceControllerInterface
-    std::uint32_t numfetchWords = 20; // number of 32-bit words to fetch from TraceRamSink
-    std::cout << "\n Fetching trace data from TraceRamSink (size: " << numfetchWords << " words)..." << std::endl;
-    std::vector<uint32_t> wordsFetched = trController.fetch(numfetchWords); // fetch trace data n words from TraceRamSink
-    
-    // Print fetched trace data
-    std::cout << "\n Fetched trace data words: ";
-    for (const auto& word : wordsFetched) {
-        std::cout << std::hex << word << " ";
-    }
-    std::cout << std::dec << std::endl; // reset to decimal
-
-    std::cout << "\n Main function finished execution" << std::endl;
-    return 0;
+/*
+    With VSCode, if you like to use CMake, the project can be built with the following command. 
+    <PowerShell terminal>
+        PS D:\Project\riscv_trace_control_interface> cmake -S . -B .\build\
+        MSBuild.exe .\build\tci.vcxproj
+        .\build\Debug\tci.exe
+*/
+
+/* 
+    Bash Terminal
+        Set GoogleTests OFF and Build 'tci_demo' exec
+        cmake -S . -B build -DTCI_BUILD_GTESTS=OFF
+        cmake --build build --target tci_demo
+        ./build/Debug/tci_demo
+
+        Set GoogleTests ON - Built both executables
+        cmake -S . -B build -DTCI_BUILD_GTESTS=ON
+        cmake --build build --target tci_demo
+        cmake --build build --target tci_gtests
+        ./build/Debug/tci_gtests
+
+        Trace farm: K systems x M instructions each on a work-stealing pool (threads: 0 = all cores)
+        ./build/tci_demo --farm 16 1000000 [threads]
+*/
+
+#include <iostream>
+#include <vector>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+
+#include "TraceSystem.h"
+#include "TraceControllerInterface.h"
+#include "ProbeHwAccess.h"
+#include "TraceDecoder.h"
+#include "TraceFarm.h"
+
+
+using namespace tci;
+
+// Probe transactions of a controller sequence and the reads saved by the shadow register cache
+static void printSequenceStats(const char* sequence, const TraceControllerInterface::SequenceStats& stats) {
+    std::cout << " [" << sequence << "] probe reads: " << stats.reads << ", writes: " << stats.writes
+              << ", reads saved: " << stats.readsSaved << ", flushes: " << stats.flushes << std::endl;
+}
+
+// --farm K M [threads]: run K systems x M instructions and report the aggregate throughput
+static int runFarm(int argc, char** argv) {
+    if (argc < 4) {
+        std::cerr << "usage: " << argv[0] << " --farm <systems> <instructions per system> [threads]" << std::endl;
+        return 1;
+    }
+    const std::size_t systems = std::strtoull(argv[2], nullptr, 0);
+    const std::size_t instructions = std::strtoull(argv[3], nullptr, 0);
+    const std::size_t threads = (argc > 4) ? std::strtoull(argv[4], nullptr, 0) : 0;
+
+    TraceFarm farm(systems, 1u << 16, threads);
+    const TraceFarm::Result result = farm.run(instructions);
+
+    std::size_t complete = 0;
+    for (std::size_t i = 0; i < farm.size(); ++i) complete += (farm.output(i).size() == 2 * instructions);
+    const double seconds = result.seconds > 0.0 ? result.seconds : 1e-9;
+    std::cout << " Trace farm: " << systems << " systems x " << instructions << " instructions on "
+              << farm.threadCount() << " threads" << std::endl;
+    std::cout << "  time: " << result.seconds << " s, " << (result.instructions / seconds / 1e6) << " M inst/s, "
+              << (4.0 * result.words / seconds / 1e6) << " MB/s captured" << std::endl;
+    std::cout << "  systems with complete output: " << complete << "/" << systems
+              << ", tasks stolen: " << farm.steals() << std::endl;
+    return complete == systems ? 0 : 1;
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1 && std::string(argv[1]) == "--farm") return runFarm(argc, argv);
+
+    // Instantiate the TraceSystem with a specified buffer size (in bytes) for TraceRamSink
+    TraceSystem trSystem(1024); // Increase buffer size if needed to hold more trace data
+
+    // Create a ProbeHwAccess that uses the TraceSystem's MMIO bus
+    // ProbeHwAccess probeAccess(trSystem.mmioBus);
+
+    // Define the component regions for logging purposes
+    std::vector<ProbeHwAccess::ComponentRegion> componentRegions = {
+        {TraceSystem::TR_TE_BASE, 0x1000, "TraceEncoder"},
+        {TraceSystem::TR_FUNNEL_BASE, 0x1000, "TraceFunnel"},
+        {TraceSystem::TR_RAM_SINK_BASE, 0x1000, "TraceRamSink"}
+    };
+    ProbeHwAccess probeAccess(trSystem.mmioBus, componentRegions);
+    
+    // TraceControllerInterface takes the probe access(ReadMemory and WriteMemory stubs) and the base addresses of the components
+    tci::TraceControllerInterface trController(probeAccess, TraceSystem::TR_TE_BASE, 
+        TraceSystem::TR_FUNNEL_BASE, TraceSystem::TR_RAM_SINK_BASE);
+
+    // Configure the trace system via the TraceControllerInterface
+    std::cout << "\n Configuring Trace System... " << std::endl;
+    trController.configure();
+    printSequenceStats("configure", trController.lastSequenceStats());
+
+    // Simulate trace generation by setting TraceEncoder active and emitting some trace data
+    std::cout << "\n Starting Trace System..." << std::endl;
+    trController.start();
+    printSequenceStats("start", trController.lastSequenceStats());
+
+    // In a real system, the TraceEncoder would emit trace data based on the execution of instructions.
+    // For this simulation, emitTrace() is called to generate some trace data.
+    trSystem.emitTrace(0x3000, 0xDEADBEEF); // example pc and opcode
+    trSystem.emitTrace(0x3004, 0xCAFEBABE); // another example pc and opcode
+    trSystem.emitTrace(0x3008, 0xAAFE1000); // another example pc and opcode
+    trSystem.emitTrace(0x300C, 0xBAFE1004); // another example pc and opcode
+    trSystem.emitTrace(0x3010, 0xEA0E1539); // another example pc and opcode
+    trSystem.emitTrace(0x3014, 0x4A2E433D); // another example pc and opcode
+
+    // Stop the trace system 
+    std::cout << "\n Stopping Trace System..." << std::endl;
+    trController.stop();
+    printSequenceStats("stop", trController.lastSequenceStats());
+
+    // Fetch trace data from TraceRamSink via TraceControllerInterface
+    std::uint32_t numfetchWords = 20; // number of 32-bit words to fetch from TraceRamSink
+    std::cout << "\n Fetching trace data from TraceRamSink (size: " << numfetchWords << " words)..." << std::endl;
+    std::vector<uint32_t> wordsFetched = trController.fetch(numfetchWords); // fetch trace data n words from TraceRamSink
+    
+    // Print fetched trace data
+    std::cout << "\n Fetched trace data words: ";
+    for (const auto& word : wordsFetched) {
+        std::cout << std::hex << word << " ";
+    }
+    std::cout << std::dec << std::endl; // reset to decimal
+
+    // Decode the raw (pc, opcode) records
+    std::vector<DecodedInstruction> decoded;
+    TraceDecoder::decodeRaw(wordsFetched, decoded);
+    std::cout << "\n Decoded instructions: " << decoded.size() << std::endl;
+    for (const auto& inst : decoded) {
+        std::cout << "  pc=0x" << std::hex << inst.pc << " opcode=0x" << inst.opcode << std::dec << std::endl;
+    }
+
+    std::cout << "\n Main function finished execution" << std::endl;
+    return 0;
 }
\ No newline at end of file